@@ -0,0 +1,58 @@
+#!/bin/bash
+#---------------------------------------------------------------------------------------------------
+# Measures how mrclean-greedy scales with the number of threads.
+#
+# Usage: scripts/bench_threads.sh <data_file> <max_missing> <row_lb> <col_lb> <na_symbol> [threads...]
+#
+# Runs the solver once per thread count (default 1 2 4 8 16 32 64), checks that every run writes
+# the same solution as the single-threaded run and prints the wall time and speedup of each.
+#---------------------------------------------------------------------------------------------------
+
+if [ $# -lt 5 ]; then
+  echo "Usage: $0 <data_file> <max_missing> <row_lb> <col_lb> <na_symbol> [threads...]" >&2
+  exit 1
+fi
+
+# The runs happen in their own directories, so a relative data file is resolved first
+DATA_FILE=$(cd "$(dirname "$1")" 2> /dev/null && pwd)/$(basename "$1")
+if [ ! -f "$DATA_FILE" ]; then
+  echo "Data file not found: $1" >&2
+  exit 1
+fi
+MAX_MISSING=$2
+ROW_LB=$3
+COL_LB=$4
+NA_SYMBOL=$5
+shift 5
+
+THREADS=${@:-1 2 4 8 16 32 64}
+EXE=$(cd "$(dirname "$0")/.." && pwd)/mrclean-greedy
+OUT_DIR=$(mktemp -d)
+trap 'rm -rf "$OUT_DIR"' EXIT
+
+printf "%8s %10s %8s %s\n" threads seconds speedup solution
+BASE_TIME=
+BASE_SOL=
+for T in $THREADS; do
+  mkdir -p "$OUT_DIR/$T"
+  START=$(date +%s.%N)
+  (cd "$OUT_DIR/$T" && "$EXE" --threads "$T" "$DATA_FILE" "$MAX_MISSING" "$ROW_LB" "$COL_LB" "$NA_SYMBOL" "$OUT_DIR/$T/" > /dev/null 2>&1) || {
+    echo "mrclean-greedy failed with $T threads" >&2
+    exit 1
+  }
+  END=$(date +%s.%N)
+  TIME=$(awk -v s="$START" -v e="$END" 'BEGIN { printf "%.3f", e - s }')
+
+  SOL=$(cat "$OUT_DIR/$T"/*.sol | cksum)
+  if [ -z "$BASE_TIME" ]; then
+    BASE_TIME=$TIME
+    BASE_SOL=$SOL
+  fi
+  STATUS=same
+  if [ "$SOL" != "$BASE_SOL" ]; then
+    STATUS=DIFFERENT
+  fi
+
+  SPEEDUP=$(awk -v b="$BASE_TIME" -v t="$TIME" 'BEGIN { printf "%.2f", (t > 0) ? b / t : 0 }')
+  printf "%8s %10s %8s %s\n" "$T" "$TIME" "$SPEEDUP" "$STATUS"
+done
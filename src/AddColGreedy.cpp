@@ -0,0 +1,8 @@
+#include "AddColGreedy.h"
+
+//------------------------------------------------------------------------------
+// Constructor.
+//------------------------------------------------------------------------------
+AddColGreedy::AddColGreedy(const BinContainer &_data,
+                           const std::size_t _row_lb,
+                           const std::size_t _col_lb) : AddRowGreedy(_data, _row_lb, _col_lb, true) {}
@@ -0,0 +1,18 @@
+#ifndef ADD_COL_GREEDY_H
+#define ADD_COL_GREEDY_H
+
+#include "AddRowGreedy.h"
+
+//------------------------------------------------------------------------------
+// Add-column greedy solver for no missing data. Columns are added one at a
+// time, and the rows with missing data in an added column are removed. This
+// is the add-row greedy solver run over the column-major words of the data.
+//------------------------------------------------------------------------------
+class AddColGreedy : public AddRowGreedy {
+public:
+  AddColGreedy(const BinContainer &_data,
+               const std::size_t _row_lb,
+               const std::size_t _col_lb);
+};
+
+#endif
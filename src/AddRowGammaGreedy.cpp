@@ -0,0 +1,296 @@
+#include "AddRowGammaGreedy.h"
+#include <assert.h>
+#include <algorithm>
+#include "MrCleanUtils.h"
+#include "PopcountKernels.h"
+
+//------------------------------------------------------------------------------
+// Constructor.
+//------------------------------------------------------------------------------
+AddRowGammaGreedy::AddRowGammaGreedy(const BinContainer &_data,
+                                     const double _max_perc_miss,
+                                     const std::size_t _row_lb,
+                                     const std::size_t _col_lb) : data(&_data),
+                                                                  num_rows(data->get_num_data_rows()),
+                                                                  num_cols(data->get_num_data_cols()),
+                                                                  max_perc_miss(_max_perc_miss),
+                                                                  row_lb(_row_lb),
+                                                                  col_lb(_col_lb),
+                                                                  best_obj_value(0),
+                                                                  best_num_rows(0),
+                                                                  best_num_removed_cols(0),
+                                                                  num_pruned_iterations(0),
+                                                                  incumbent(nullptr),
+                                                                  included_cols(mr_clean_utils::make_full_mask(num_cols)),
+                                                                  num_included_cols(num_cols),
+                                                                  included_row_mask(mr_clean_utils::num_words(num_rows), 0),
+                                                                  excluded_rows(mr_clean_utils::make_full_mask(num_rows)),
+                                                                  num_excluded_rows(num_rows),
+                                                                  alphas(num_rows, 0),
+                                                                  alpha_buckets(num_cols + 1),
+                                                                  alpha_pos(num_rows, 0),
+                                                                  best_alpha(0),
+                                                                  row_miss(num_rows, 0),
+                                                                  miss_buckets(num_cols + 1),
+                                                                  miss_pos(num_rows, 0),
+                                                                  worst_row_miss(0),
+                                                                  col_miss(num_cols, 0),
+                                                                  num_missing(0) {
+  included_rows.reserve(num_rows);
+  removed_cols.reserve(num_cols);
+
+  // Initialize alphas & set all rows to excluded
+  for (std::size_t i = 0; i < num_rows; ++i) {
+    alphas[i] = popcount_kernels::count(data->get_row_words(i), data->get_num_row_words());
+    mr_clean_utils::add_to_bucket(alpha_buckets, alpha_pos, alphas[i], i);
+    best_alpha = std::max(best_alpha, alphas[i]);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Destructor.
+//------------------------------------------------------------------------------
+AddRowGammaGreedy::~AddRowGammaGreedy() {}
+
+//------------------------------------------------------------------------------
+// Makes solve() also stop once no later inclusion can reach '_incumbent',
+// shared with other solvers. Inclusions that could tie it still run.
+//------------------------------------------------------------------------------
+void AddRowGammaGreedy::set_incumbent(const std::atomic<std::size_t> *_incumbent) {
+  incumbent = _incumbent;
+}
+
+//------------------------------------------------------------------------------
+// Finds the greedy solution to the cleaning problem. To begin, all rows are
+// excluded from the solution. Rows are iteratively added to the solution, the
+// one with the most valid elements in the included columns first. After each
+// inclusion, the columns whose percent missing is over the maximum are
+// removed, then, while an included row is over the maximum, the column with
+// the most missing elements among that row's missing columns. The number of
+// valid elements in the solution is calculated after each row inclusion and
+// the best is later returned. The loop stops early once no later inclusion can
+// beat the incumbent.
+//------------------------------------------------------------------------------
+void AddRowGammaGreedy::solve() {
+  while (num_excluded_rows > 0) {
+    if (!can_improve()) {
+      num_pruned_iterations = num_excluded_rows;
+      break;
+    }
+
+    std::size_t next_row = get_next_row();
+    include_row(next_row);
+    remove_cols_over_threshold(next_row);
+
+    std::size_t cur_obj = calc_obj();
+    if (cur_obj > best_obj_value &&
+        included_rows.size() >= row_lb &&
+        num_included_cols >= col_lb) {
+      best_obj_value = cur_obj;
+      best_num_rows = included_rows.size();
+      best_num_removed_cols = removed_cols.size();
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Calculates the number of valid elements in the solution.
+//------------------------------------------------------------------------------
+std::size_t AddRowGammaGreedy::calc_obj() const {
+  return included_rows.size() * num_included_cols - num_missing;
+}
+
+//------------------------------------------------------------------------------
+// Returns true if including more rows could still give a better objective
+// than the incumbent, and reach the shared incumbent, if any. Columns are only
+// removed, so no later solution keeps more than every row times the included
+// columns.
+//------------------------------------------------------------------------------
+bool AddRowGammaGreedy::can_improve() const {
+  const std::size_t bound = num_rows * num_included_cols;
+  return num_included_cols >= col_lb &&
+         num_included_cols > 0 &&
+         bound > best_obj_value &&
+         (incumbent == nullptr || bound >= incumbent->load(std::memory_order_relaxed));
+}
+
+//------------------------------------------------------------------------------
+// Returns the excluded row with the most valid elements in the included
+// columns, the lowest index on ties.
+//------------------------------------------------------------------------------
+std::size_t AddRowGammaGreedy::get_next_row() {
+  while (alpha_buckets[best_alpha].empty()) {
+    --best_alpha;
+  }
+  return *std::min_element(alpha_buckets[best_alpha].begin(), alpha_buckets[best_alpha].end());
+}
+
+//------------------------------------------------------------------------------
+// Moves 'row' from the excluded rows to the included rows and adds its
+// missing elements to the counts of the included columns.
+//------------------------------------------------------------------------------
+void AddRowGammaGreedy::include_row(const std::size_t row) {
+  assert(mr_clean_utils::test_bit(excluded_rows.data(), row));
+
+  mr_clean_utils::clear_bit(excluded_rows.data(), row);
+  mr_clean_utils::set_bit(included_row_mask.data(), row);
+  mr_clean_utils::remove_from_bucket(alpha_buckets, alpha_pos, alphas[row], row);
+  --num_excluded_rows;
+  included_rows.push_back(row);
+
+  const uint64_t *words = data->get_row_words(row);
+  std::size_t num_row_miss = 0;
+  for (std::size_t w = 0; w < included_cols.size(); ++w) {
+    uint64_t bits = ~words[w] & included_cols[w];
+    while (bits) {
+      ++col_miss[(w << 6) + __builtin_ctzll(bits)];
+      ++num_row_miss;
+      bits &= bits - 1;
+    }
+  }
+
+  row_miss[row] = num_row_miss;
+  num_missing += num_row_miss;
+  mr_clean_utils::add_to_bucket(miss_buckets, miss_pos, num_row_miss, row);
+  worst_row_miss = std::max(worst_row_miss, num_row_miss);
+}
+
+//------------------------------------------------------------------------------
+// Restores the maximum percent missing after 'row' was included. Only the
+// columns missing in 'row' gained a missing element, so only they can be over
+// the column threshold. Removing columns lowers the row threshold, so rows are
+// then checked, worst first and the lowest index on ties, until none is over
+// it.
+//------------------------------------------------------------------------------
+void AddRowGammaGreedy::remove_cols_over_threshold(const std::size_t row) {
+  const std::size_t max_col_miss = mr_clean_utils::calc_max_num_missing(max_perc_miss, included_rows.size());
+  const uint64_t *words = data->get_row_words(row);
+  for (std::size_t w = 0; w < included_cols.size(); ++w) {
+    uint64_t bits = ~words[w] & included_cols[w];
+    while (bits) {
+      const std::size_t j = (w << 6) + __builtin_ctzll(bits);
+      if (col_miss[j] > max_col_miss) {
+        remove_col(j);
+      }
+      bits &= bits - 1;
+    }
+  }
+
+  while (true) {
+    while (worst_row_miss > 0 && miss_buckets[worst_row_miss].empty()) {
+      --worst_row_miss;
+    }
+    if (worst_row_miss <= mr_clean_utils::calc_max_num_missing(max_perc_miss, num_included_cols)) {
+      break;
+    }
+    const std::vector<std::size_t> &worst_rows = miss_buckets[worst_row_miss];
+    remove_col(get_worst_missing_col(*std::min_element(worst_rows.begin(), worst_rows.end())));
+  }
+}
+
+//------------------------------------------------------------------------------
+// Returns the included column missing in 'row' with the most missing
+// elements, the lowest index on ties.
+//------------------------------------------------------------------------------
+std::size_t AddRowGammaGreedy::get_worst_missing_col(const std::size_t row) const {
+  const uint64_t *words = data->get_row_words(row);
+  std::size_t worst_col = num_cols;
+  for (std::size_t w = 0; w < included_cols.size(); ++w) {
+    uint64_t bits = ~words[w] & included_cols[w];
+    while (bits) {
+      const std::size_t j = (w << 6) + __builtin_ctzll(bits);
+      if (worst_col == num_cols || col_miss[j] > col_miss[worst_col]) {
+        worst_col = j;
+      }
+      bits &= bits - 1;
+    }
+  }
+
+  assert(worst_col < num_cols);
+  return worst_col;
+}
+
+//------------------------------------------------------------------------------
+// Removes 'col' from the solution. Included rows missing it lose a missing
+// element and excluded rows valid in it lose a valid element.
+//------------------------------------------------------------------------------
+void AddRowGammaGreedy::remove_col(const std::size_t col) {
+  assert(mr_clean_utils::test_bit(included_cols.data(), col));
+
+  mr_clean_utils::clear_bit(included_cols.data(), col);
+  --num_included_cols;
+  removed_cols.push_back(col);
+  num_missing -= col_miss[col];
+  col_miss[col] = 0;
+
+  const uint64_t *words = data->get_col_words(col);
+  for (std::size_t v = 0; v < excluded_rows.size(); ++v) {
+    uint64_t missing = ~words[v] & included_row_mask[v];
+    while (missing) {
+      const std::size_t i = (v << 6) + __builtin_ctzll(missing);
+      mr_clean_utils::remove_from_bucket(miss_buckets, miss_pos, row_miss[i], i);
+      --row_miss[i];
+      mr_clean_utils::add_to_bucket(miss_buckets, miss_pos, row_miss[i], i);
+      missing &= missing - 1;
+    }
+
+    uint64_t valid = words[v] & excluded_rows[v];
+    while (valid) {
+      const std::size_t i = (v << 6) + __builtin_ctzll(valid);
+      mr_clean_utils::remove_from_bucket(alpha_buckets, alpha_pos, alphas[i], i);
+      --alphas[i];
+      mr_clean_utils::add_to_bucket(alpha_buckets, alpha_pos, alphas[i], i);
+      valid &= valid - 1;
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Returns a boolean vector where elements are 'true' if the corresponding row
+// is kept and 'false' if the row is removed.
+//------------------------------------------------------------------------------
+std::vector<bool> AddRowGammaGreedy::get_rows_to_keep() const {
+  std::vector<bool> rows_to_keep(num_rows, 0);
+
+  for (std::size_t i = 0; i < best_num_rows; ++i) {
+    rows_to_keep[included_rows[i]] = 1;
+  }
+
+  return rows_to_keep;
+}
+
+//------------------------------------------------------------------------------
+// Returns a boolean vector where elements are 'true' if the corresponding
+// column is kept and 'false' if the column is removed.
+//------------------------------------------------------------------------------
+std::vector<bool> AddRowGammaGreedy::get_cols_to_keep() const {
+  std::vector<bool> cols_to_keep(num_cols, 1);
+
+  for (std::size_t k = 0; k < best_num_removed_cols; ++k) {
+    cols_to_keep[removed_cols[k]] = 0;
+  }
+
+  return cols_to_keep;
+}
+
+//------------------------------------------------------------------------------
+// Returns the number of rows kept in the best solution.
+//------------------------------------------------------------------------------
+std::size_t AddRowGammaGreedy::get_num_rows_to_keep() const {
+  return best_num_rows;
+}
+
+//------------------------------------------------------------------------------
+// Returns the number of columns kept in the best solution.
+//------------------------------------------------------------------------------
+std::size_t AddRowGammaGreedy::get_num_cols_to_keep() const {
+  return num_cols - best_num_removed_cols;
+}
+
+//------------------------------------------------------------------------------
+// Returns the number of row inclusions skipped because they could not improve
+// the incumbent.
+//------------------------------------------------------------------------------
+std::size_t AddRowGammaGreedy::get_num_pruned_iterations() const {
+  return num_pruned_iterations;
+}
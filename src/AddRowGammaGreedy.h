@@ -0,0 +1,79 @@
+#ifndef ADD_ROW_GAMMA_GREEDY_H
+#define ADD_ROW_GAMMA_GREEDY_H
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+#include "BinContainer.h"
+
+//------------------------------------------------------------------------------
+// Add-row greedy solver for a maximum percent missing above zero. Rows are
+// added one at a time, and after each inclusion only the columns needed to
+// keep every included row and column within the maximum percent missing are
+// removed.
+//------------------------------------------------------------------------------
+class AddRowGammaGreedy {
+private:
+  const BinContainer *data;
+  const std::size_t num_rows;
+  const std::size_t num_cols;
+  const double max_perc_miss;
+  const std::size_t row_lb;
+  const std::size_t col_lb;
+
+  std::size_t best_obj_value;
+  std::size_t best_num_rows;
+  std::size_t best_num_removed_cols;
+  std::size_t num_pruned_iterations;
+  const std::atomic<std::size_t> *incumbent;
+
+  std::vector<uint64_t> included_cols;
+  std::size_t num_included_cols;
+  std::vector<std::size_t> removed_cols;
+  std::vector<uint64_t> included_row_mask;
+  std::vector<uint64_t> excluded_rows;
+  std::size_t num_excluded_rows;
+  std::vector<std::size_t> included_rows;
+
+  // Valid elements of excluded rows in included columns, bucketed by value
+  std::vector<std::size_t> alphas;
+  std::vector<std::vector<std::size_t>> alpha_buckets;
+  std::vector<std::size_t> alpha_pos;
+  std::size_t best_alpha;
+
+  // Missing elements of included rows in included columns, bucketed by value,
+  // and of included columns in included rows
+  std::vector<std::size_t> row_miss;
+  std::vector<std::vector<std::size_t>> miss_buckets;
+  std::vector<std::size_t> miss_pos;
+  std::size_t worst_row_miss;
+  std::vector<std::size_t> col_miss;
+  std::size_t num_missing;
+
+  std::size_t calc_obj() const;
+  bool can_improve() const;
+
+  std::size_t get_next_row();
+  void include_row(const std::size_t row);
+  void remove_cols_over_threshold(const std::size_t row);
+  std::size_t get_worst_missing_col(const std::size_t row) const;
+  void remove_col(const std::size_t col);
+
+public:
+  AddRowGammaGreedy(const BinContainer &_data,
+                    const double _max_perc_miss,
+                    const std::size_t _row_lb,
+                    const std::size_t _col_lb);
+  ~AddRowGammaGreedy();
+
+  void set_incumbent(const std::atomic<std::size_t> *_incumbent);
+  void solve();
+
+  std::vector<bool> get_rows_to_keep() const;
+  std::vector<bool> get_cols_to_keep() const;
+  std::size_t get_num_rows_to_keep() const;
+  std::size_t get_num_cols_to_keep() const;
+  std::size_t get_num_pruned_iterations() const;
+};
+
+#endif
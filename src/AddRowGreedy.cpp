@@ -1,32 +1,56 @@
 #include "AddRowGreedy.h"
 #include <assert.h>
 #include <algorithm>
+#include "MrCleanUtils.h"
+#include "PopcountKernels.h"
 
 //------------------------------------------------------------------------------
 // Constructor.
 //------------------------------------------------------------------------------
 AddRowGreedy::AddRowGreedy(const BinContainer &_data,
                            const std::size_t _row_lb,
-                           const std::size_t _col_lb) : data(&_data),
-                                                          num_rows(data->get_num_data_rows()),
-                                                          num_cols(data->get_num_data_cols()),
-                                                          row_lb(_row_lb),
-                                                          col_lb(_col_lb),
-                                                          best_obj_value(0),
-                                                          best_num_rows(0),
-                                                          columns(num_cols, true),
-                                                          num_included_cols(num_cols),
-                                                          alphas(num_rows, 0),
-                                                          excluded_rows(num_rows) {
+                           const std::size_t _col_lb) : AddRowGreedy(_data, _row_lb, _col_lb, false) {}
+
+//------------------------------------------------------------------------------
+// Constructor. With '_transpose' set, the data's columns are added instead of
+// its rows.
+//------------------------------------------------------------------------------
+AddRowGreedy::AddRowGreedy(const BinContainer &_data,
+                           const std::size_t _row_lb,
+                           const std::size_t _col_lb,
+                           const bool _transpose) : data(&_data),
+                                                    transpose(_transpose),
+                                                    num_rows(transpose ? data->get_num_data_cols() : data->get_num_data_rows()),
+                                                    num_cols(transpose ? data->get_num_data_rows() : data->get_num_data_cols()),
+                                                    row_lb(transpose ? _col_lb : _row_lb),
+                                                    col_lb(transpose ? _row_lb : _col_lb),
+                                                    best_obj_value(0),
+                                                    best_num_rows(0),
+                                                    num_pruned_iterations(0),
+                                                    incumbent(nullptr),
+                                                    recording(false),
+                                                    included_cols(mr_clean_utils::make_full_mask(num_cols)),
+                                                    num_included_cols(num_cols),
+                                                    alphas(num_rows, 0),
+                                                    excluded_rows(mr_clean_utils::make_full_mask(num_rows)),
+                                                    num_excluded_rows(num_rows),
+                                                    alpha_buckets(num_cols + 1),
+                                                    bucket_pos(num_rows, 0),
+                                                    best_alpha(0),
+                                                    col_num_miss(num_cols, 0),
+                                                    col_alpha_sum(num_cols, 0),
+                                                    candidate_cols(get_num_row_words(), 0),
+                                                    near_rows(3, std::vector<uint64_t>(get_num_col_words(), 0)),
+                                                    window_alpha(0) {
   // Initialize alphas & set all rows to excluded
   for (std::size_t i = 0; i < num_rows; ++i) {
-    for (std::size_t j = 0; j < num_cols; ++j) {
-      if (!data->is_data_na(i,j)) {
-        ++alphas[i];
-      }
-    }
-    excluded_rows[i] = i;
-  }  
+    alphas[i] = popcount_kernels::count(get_row_words(i), get_num_row_words());
+    best_alpha = std::max(best_alpha, alphas[i]);
+  }
+  window_alpha = best_alpha;
+  for (std::size_t i = 0; i < num_rows; ++i) {
+    add_to_bucket(i);
+  }
 }
 
 //------------------------------------------------------------------------------
@@ -40,11 +64,17 @@ AddRowGreedy::~AddRowGreedy() {}
 // each row inclusion, columns with missing data in the included row are
 // removed. The number of valid elements in the solution is calculated after
 // each row inclusion and the best is later returned as the greedy objective
-// value.
+// value. The loop stops early once no later inclusion can beat the incumbent,
+// unless the trajectory is recorded.
 //------------------------------------------------------------------------------
 void AddRowGreedy::solve() {
-  // Loop until all rows are included
-  while (!excluded_rows.empty()) {
+  // Loop until all rows are included or the incumbent cannot be improved
+  while (num_excluded_rows > 0) {
+    if (!recording && !can_improve()) {
+      num_pruned_iterations = num_excluded_rows;
+      break;
+    }
+
     // Find next row to include
     std::size_t nextRow = get_next_row();
 
@@ -54,6 +84,10 @@ void AddRowGreedy::solve() {
     // Update alphas
     update_alphas(nextRow);
 
+    if (recording) {
+      num_cols_by_step.push_back(num_included_cols);
+    }
+
     // Calculate new objective
     std::size_t cur_obj = calc_obj();
 
@@ -67,6 +101,33 @@ void AddRowGreedy::solve() {
   }
 }
 
+//------------------------------------------------------------------------------
+// Makes solve() include every row and keep the number of included columns
+// after each inclusion. The order of the inclusions does not depend on
+// row_lb or col_lb, so the best solution for any bounds can later be read
+// from the trajectory.
+//------------------------------------------------------------------------------
+void AddRowGreedy::record_trajectory() {
+  recording = true;
+  num_cols_by_step.reserve(num_rows);
+}
+
+//------------------------------------------------------------------------------
+// Breaks ties between candidate rows in an order drawn from 'seed' instead of
+// by the lowest index.
+//------------------------------------------------------------------------------
+void AddRowGreedy::randomize_ties(const uint64_t seed) {
+  row_rank = mr_clean_utils::make_random_ranks(num_rows, seed);
+}
+
+//------------------------------------------------------------------------------
+// Makes solve() also stop once no later inclusion can reach '_incumbent',
+// shared with other solvers. Inclusions that could tie it still run.
+//------------------------------------------------------------------------------
+void AddRowGreedy::set_incumbent(const std::atomic<std::size_t> *_incumbent) {
+  incumbent = _incumbent;
+}
+
 //------------------------------------------------------------------------------
 // Calculates the number of valid elements in the solution by mulitplying the
 // number of included rows by the number of included columns.
@@ -76,114 +137,237 @@ std::size_t AddRowGreedy::calc_obj() const {
 }
 
 //------------------------------------------------------------------------------
-// Selects the next row to add to the solution. First, the row with the best
-// alpha is identified. If only 1 row contains the best alpha, it is selected
-// as the next row to add. If multiple rows have the best alpha, determine which
-// row would removed the most missing elements in rows with similar alpha. Pick
-// the row that will remove the most missing data. Any secondary ties are broken
-// based on the numbe of valid elements in the rows with missing data.
+// Returns true if including more rows could still give a better objective
+// than the incumbent. A solution with 'r' more rows keeps at most the alpha of
+// each of them in columns, so at most the r-th largest excluded alpha. The
+// bound is the best of (included + r) * (r-th largest alpha) over r, skipping
+// alphas below the column lower bound. Alphas only decrease, so the bound only
+// tightens.
+//------------------------------------------------------------------------------
+bool AddRowGreedy::can_improve() const {
+  const std::size_t max_rows = included_rows.size() + num_excluded_rows;
+  std::size_t num_rows_added = 0;
+  for (std::size_t a = best_alpha + 1; a-- > std::max<std::size_t>(col_lb, 1);) {
+    // No smaller alpha can do better even with every excluded row
+    if (!can_beat(max_rows * a)) {
+      return false;
+    }
+    num_rows_added += alpha_buckets[a].size();
+    if (num_rows_added > 0 &&
+        included_rows.size() + num_rows_added >= row_lb &&
+        can_beat((included_rows.size() + num_rows_added) * a)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+//------------------------------------------------------------------------------
+// Returns true if a solution with 'bound' valid elements would beat the
+// incumbent and reach the shared incumbent, if any.
+//------------------------------------------------------------------------------
+bool AddRowGreedy::can_beat(const std::size_t bound) const {
+  return bound > best_obj_value &&
+         (incumbent == nullptr || bound >= incumbent->load(std::memory_order_relaxed));
+}
+
+//------------------------------------------------------------------------------
+// Selects the next row to add to the solution from the rows with the best
+// alpha. For each included column with missing data in a candidate row, count
+// the missing elements in excluded rows with an alpha within 3 of the best,
+// which including the candidate would remove, and sum the alphas of those
+// rows. The candidate whose worst column removes the most missing elements is
+// picked. Ties are broken by the largest alpha sum over the candidate's
+// columns, then by the lowest row index, or rank when the ties are randomized.
+//
+// The column counts do not depend on the candidate, so they are computed once,
+// either from the missing bits of the rows in the top 3 alpha buckets or from
+// the column-major words of the candidates' columns, whichever reads fewer
+// words.
 //------------------------------------------------------------------------------
 std::size_t AddRowGreedy::get_next_row() {
-  std::size_t next_row = excluded_rows[0];
-  std::size_t best_alpha = alphas[next_row];
-
-  // Find the best alpha and the row that contains it. Note if multiple rows
-  // contain best alpha
-  bool multi_found = false;
-  for (std::size_t k = 0; k < excluded_rows.size(); ++k) {
-    std::size_t i = excluded_rows[k];
-    if (alphas[i] > best_alpha) {
-      best_alpha = alphas[i];
-      next_row = i;
-    } else if (alphas[i] == best_alpha) {
-      multi_found = true;
+  while (alpha_buckets[best_alpha].empty()) {
+    --best_alpha;
+  }
+  slide_window();
+
+  const std::size_t num_row_words = get_num_row_words();
+  const std::size_t lowest_alpha = best_alpha < 2 ? 0 : best_alpha - 2;
+
+  // Columns that can decide the selection
+  for (auto i : alpha_buckets[best_alpha]) {
+    const uint64_t *row = get_row_words(i);
+    for (std::size_t w = 0; w < num_row_words; ++w) {
+      candidate_cols[w] |= ~row[w] & included_cols[w];
     }
   }
+  const std::size_t num_candidate_cols = popcount_kernels::count(candidate_cols.data(), num_row_words);
+
+  std::size_t num_near_rows = 0;
+  for (std::size_t a = lowest_alpha; a <= best_alpha; ++a) {
+    num_near_rows += alpha_buckets[a].size();
+  }
 
-  // Check if multiple rows contain best alpha
-  if (multi_found) {
-    // Get all rows with best alpha
-    std::vector<std::size_t> possible_rows;
-    for (auto i : excluded_rows) {
-      if (alphas[i] == best_alpha) {
-        possible_rows.push_back(i);
+  if (num_candidate_cols > 0) {
+    const std::size_t num_col_words = get_num_col_words();
+    if (num_near_rows * num_row_words <= num_candidate_cols * (best_alpha - lowest_alpha + 1) * num_col_words) {
+      count_missing_by_rows(lowest_alpha);
+    } else {
+      count_missing_by_cols(lowest_alpha);
+    }
+  }
+  std::fill(candidate_cols.begin(), candidate_cols.end(), 0);
+
+  std::size_t next_row = 0;
+  std::size_t best_num_miss = 0;
+  std::size_t best_alpha_sum = 0;
+  bool found = false;
+  for (auto i : alpha_buckets[best_alpha]) {
+    std::size_t worst_num_miss = 0;
+    std::size_t alpha_sum = 0;
+    const uint64_t *row = get_row_words(i);
+    for (std::size_t w = 0; w < num_row_words; ++w) {
+      uint64_t bits = ~row[w] & included_cols[w];
+      while (bits) {
+        const std::size_t j = (w << 6) + __builtin_ctzll(bits);
+        worst_num_miss = std::max(worst_num_miss, col_num_miss[j]);
+        alpha_sum += col_alpha_sum[j];
+        bits &= bits - 1;
       }
     }
 
-    // Allocate memory for stats for each possible row
-    std::vector<std::size_t> worst_num_miss(possible_rows.size(), 0);
-    std::vector<std::size_t> alpha_sum(possible_rows.size(), 0);
-    std::size_t overall_worst_num_miss = 0;
-    
-    // Loop through all rows with best alpha
-    for (std::size_t i_pos_row = 0; i_pos_row < possible_rows.size(); ++i_pos_row) {
-      std::size_t i = possible_rows[i_pos_row];
-    
-      // Loop though all columns
-      for (std::size_t j = 0; j < num_cols; ++j) {
-        // Check that column is included and the element (i,j) is missing
-        // NOTE: These columns would be exluded if the row was added to the solution
-        if (columns[j] && data->is_data_na(i,j)) {      
-
-          // Count the number of missing elements in currently excluded rows & included columns, that would be
-          // removed if row 'i' is included. Also sum the alphas of the rows with these missing elements. Only
-          // consider rows with alphas within 3 of the row 'i'
-          // Loop through all excluded rows
-          std::size_t num_miss = 0;
-          for (auto ii : excluded_rows) {
-            // Check that the data is missing in the 'ii' row and that alpha value of row ii is close to bestAlpha            
-            if (data->is_data_na(ii, j) && (best_alpha - alphas[ii] < 3)) {
-              ++num_miss;
-              alpha_sum[i_pos_row] += alphas[ii];
-            }
-          }
+    if (!found ||
+        worst_num_miss > best_num_miss ||
+        (worst_num_miss == best_num_miss && (alpha_sum > best_alpha_sum ||
+                                             (alpha_sum == best_alpha_sum &&
+                                              (row_rank.empty() ? i < next_row : row_rank[i] < row_rank[next_row]))))) {
+      next_row = i;
+      best_num_miss = worst_num_miss;
+      best_alpha_sum = alpha_sum;
+      found = true;
+    }
+  }
 
-          if (num_miss > worst_num_miss[i_pos_row]) {
-            worst_num_miss[i_pos_row] = num_miss;
-          }
+  for (auto j : touched_cols) {
+    col_num_miss[j] = 0;
+    col_alpha_sum[j] = 0;
+  }
+  touched_cols.clear();
 
-          if (num_miss > overall_worst_num_miss) {
-            overall_worst_num_miss = num_miss;
-            next_row = i;
+  return next_row;
+}
+
+//------------------------------------------------------------------------------
+// Counts the missing elements, and sums the alphas, per included column over
+// the rows with an alpha of at least 'lowest_alpha' by walking the missing
+// bits of each row.
+//------------------------------------------------------------------------------
+void AddRowGreedy::count_missing_by_rows(const std::size_t lowest_alpha) {
+  const std::size_t num_row_words = get_num_row_words();
+  for (std::size_t a = lowest_alpha; a <= best_alpha; ++a) {
+    for (auto ii : alpha_buckets[a]) {
+      const uint64_t *row = get_row_words(ii);
+      for (std::size_t w = 0; w < num_row_words; ++w) {
+        uint64_t bits = ~row[w] & included_cols[w];
+        while (bits) {
+          const std::size_t j = (w << 6) + __builtin_ctzll(bits);
+          if (col_num_miss[j] == 0) {
+            touched_cols.push_back(j);
           }
+          ++col_num_miss[j];
+          col_alpha_sum[j] += a;
+          bits &= bits - 1;
         }
       }
     }
-    
-    // Select the row, from the possible_rows, that would remove the most missing elements.
-    // Break any ties with the row that has the best alpha_sum
-    std::size_t best_alpha_sum = 0;
-    for (std::size_t i = 0; i < worst_num_miss.size(); ++i) {
-      if ((worst_num_miss[i] == overall_worst_num_miss) && (alpha_sum[i] > best_alpha_sum)) {
-        next_row = possible_rows[i];
-        best_alpha_sum = alpha_sum[i];        
+  }
+}
+
+//------------------------------------------------------------------------------
+// Counts the missing elements, and sums the alphas, for the candidate columns
+// only. The missing elements of a column in a bucket are the bucket size less
+// the popcount of the column's valid words under the bucket's row mask.
+//------------------------------------------------------------------------------
+void AddRowGreedy::count_missing_by_cols(const std::size_t lowest_alpha) {
+  const std::size_t num_col_words = get_num_col_words();
+  for (std::size_t w = 0; w < candidate_cols.size(); ++w) {
+    uint64_t bits = candidate_cols[w];
+    while (bits) {
+      const std::size_t j = (w << 6) + __builtin_ctzll(bits);
+      const uint64_t *col = get_col_words(j);
+      for (std::size_t a = lowest_alpha; a <= best_alpha; ++a) {
+        const std::size_t num_miss = alpha_buckets[a].size() -
+                                     popcount_kernels::count_and(col, near_rows[a % 3].data(), num_col_words);
+        col_num_miss[j] += num_miss;
+        col_alpha_sum[j] += a * num_miss;
       }
+      touched_cols.push_back(j);
+      bits &= bits - 1;
     }
   }
-
-  return next_row;
 }
 
 //------------------------------------------------------------------------------
 // This function adds the 'row' to the included row vector and removes it from
-// the excluded row vector. If 'row' is not found in the excluded vector an 
-// error is reported.
+// the excluded rows. If 'row' is not excluded an error is reported.
 //------------------------------------------------------------------------------
 void AddRowGreedy::include_row(const std::size_t row) {
+  if (!mr_clean_utils::test_bit(excluded_rows.data(), row)) {
+    fprintf(stderr, "ERROR - Could not find row %lu in excluded set\n", row);
+    return;
+  }
+
   // Add row to included set
   included_rows.push_back(row);
+  mr_clean_utils::clear_bit(excluded_rows.data(), row);
+  --num_excluded_rows;
+  remove_from_bucket(row);
+}
 
-  // Find index of row in excluded set
-  for (std::size_t i = 0; i < excluded_rows.size(); ++i) {
-    if (excluded_rows[i] == row) {
-      excluded_rows.erase(excluded_rows.begin() + i);
-      return;
-    }
+//------------------------------------------------------------------------------
+// Adds 'row' to the bucket of its alpha.
+//------------------------------------------------------------------------------
+void AddRowGreedy::add_to_bucket(const std::size_t row) {
+  mr_clean_utils::add_to_bucket(alpha_buckets, bucket_pos, alphas[row], row);
+  if (is_in_window(alphas[row])) {
+    mr_clean_utils::set_bit(near_rows[alphas[row] % 3].data(), row);
   }
+}
 
-  fprintf(stderr, "ERROR - Could not find row %lu in excluded set\n", row);
+//------------------------------------------------------------------------------
+// Removes 'row' from the bucket of its alpha by moving the last row of the
+// bucket into its place.
+//------------------------------------------------------------------------------
+void AddRowGreedy::remove_from_bucket(const std::size_t row) {
+  mr_clean_utils::remove_from_bucket(alpha_buckets, bucket_pos, alphas[row], row);
+  if (is_in_window(alphas[row])) {
+    mr_clean_utils::clear_bit(near_rows[alphas[row] % 3].data(), row);
+  }
 }
 
+//------------------------------------------------------------------------------
+// Returns true if the bucket of 'alpha' has an up to date row mask.
+//------------------------------------------------------------------------------
+bool AddRowGreedy::is_in_window(const std::size_t alpha) const {
+  return alpha <= window_alpha && alpha + 2 >= window_alpha;
+}
+
+//------------------------------------------------------------------------------
+// Moves the window of row masks down to best_alpha. The buckets above
+// best_alpha are empty, so their masks are already clear, and each bucket
+// entering the window has its mask built from its rows.
+//------------------------------------------------------------------------------
+void AddRowGreedy::slide_window() {
+  while (window_alpha > best_alpha) {
+    --window_alpha;
+    if (window_alpha >= 2) {
+      const std::size_t a = window_alpha - 2;
+      for (auto ii : alpha_buckets[a]) {
+        mr_clean_utils::set_bit(near_rows[a % 3].data(), ii);
+      }
+    }
+  }
+}
 
 //------------------------------------------------------------------------------
 // This function receives the latest row that was added / included in the
@@ -191,32 +375,42 @@ void AddRowGreedy::include_row(const std::size_t row) {
 // corresponding to the received row. If a column has missing data in the
 // received row, it is removed from the solution. The alpha value (number of
 // valid elements in included columns) for each excluded row is updated based on
-// any removed columns.
+// any removed columns, which moves the row down one bucket.
 //------------------------------------------------------------------------------
 void AddRowGreedy::update_alphas(const std::size_t row) {
-  // Loop through all columns
-  for (std::size_t j = 0; j < columns.size(); ++j) {
-    // Check if column is currently in solution & is missing in 'row'
-    if (columns[j] && data->is_data_na(row, j)) {
-      columns[j] = false;
+  const uint64_t *row_words = get_row_words(row);
+  const std::size_t num_col_words = get_num_col_words();
+
+  for (std::size_t w = 0; w < included_cols.size(); ++w) {
+    // Included columns that are missing in 'row'
+    uint64_t removed = ~row_words[w] & included_cols[w];
+    included_cols[w] &= ~removed;
+    while (removed) {
+      const std::size_t j = (w << 6) + __builtin_ctzll(removed);
       --num_included_cols;
 
-      // Loop through all excluded rows
-      for (auto i : excluded_rows) {
-        // Check if element in NOT missing
-        if (!data->is_data_na(i,j)) {
-          --alphas[i]; // Decrement alpha
+      // Excluded rows with a valid element in the column
+      const uint64_t *col = get_col_words(j);
+      for (std::size_t v = 0; v < num_col_words; ++v) {
+        uint64_t bits = col[v] & excluded_rows[v];
+        while (bits) {
+          const std::size_t i = (v << 6) + __builtin_ctzll(bits);
+          remove_from_bucket(i);
+          --alphas[i];
+          add_to_bucket(i);
+          bits &= bits - 1;
         }
       }
+      removed &= removed - 1;
     }
   }
 }
 
 //------------------------------------------------------------------------------
 // Returns a boolean vector where elements are 'true' if the corresponding row
-// is kept and 'false' if the row is removed.
+// of the solver is in the best solution.
 //------------------------------------------------------------------------------
-std::vector<bool> AddRowGreedy::get_rows_to_keep() const {
+std::vector<bool> AddRowGreedy::get_included_rows() const {
   std::vector<bool> rows_to_keep(num_rows, 0);
 
   for (std::size_t i = 0; i < best_num_rows; ++i) {
@@ -229,46 +423,85 @@ std::vector<bool> AddRowGreedy::get_rows_to_keep() const {
 
 //------------------------------------------------------------------------------
 // Returns a boolean vector where elements are 'true' if the corresponding
-// column is kept and 'false' if the column is removed.
+// column of the solver is in the best solution, i.e. is valid in every
+// included row.
 //------------------------------------------------------------------------------
-std::vector<bool> AddRowGreedy::get_cols_to_keep() const {
-  std::vector<bool> cols_to_keep(num_cols, 1);
+std::vector<bool> AddRowGreedy::get_included_cols() const {
+  std::vector<uint64_t> valid = mr_clean_utils::make_full_mask(num_cols);
 
-  for (std::size_t j = 0; j < num_cols; ++j) {
-    for (std::size_t k = 0; k < best_num_rows; ++k) {
-      std::size_t i = included_rows[k];
-      if (data->is_data_na(i,j)) {
-        cols_to_keep[j] = 0;
-        break;
-      }
+  for (std::size_t k = 0; k < best_num_rows; ++k) {
+    const uint64_t *row = get_row_words(included_rows[k]);
+    for (std::size_t w = 0; w < valid.size(); ++w) {
+      valid[w] &= row[w];
     }
   }
 
+  std::vector<bool> cols_to_keep(num_cols, 0);
+  for (std::size_t j = 0; j < num_cols; ++j) {
+    cols_to_keep[j] = mr_clean_utils::test_bit(valid.data(), j);
+  }
+
   return cols_to_keep;
 }
 
+//------------------------------------------------------------------------------
+// Returns true if a solution within the row and column lower bounds was found.
+//------------------------------------------------------------------------------
+bool AddRowGreedy::has_solution() const {
+  return best_num_rows > 0;
+}
+
+//------------------------------------------------------------------------------
+// Returns a boolean vector where elements are 'true' if the corresponding row
+// is kept and 'false' if the row is removed.
+//------------------------------------------------------------------------------
+std::vector<bool> AddRowGreedy::get_rows_to_keep() const {
+  return transpose ? get_included_cols() : get_included_rows();
+}
+
+//------------------------------------------------------------------------------
+// Returns a boolean vector where elements are 'true' if the corresponding
+// column is kept and 'false' if the column is removed.
+//------------------------------------------------------------------------------
+std::vector<bool> AddRowGreedy::get_cols_to_keep() const {
+  return transpose ? get_included_rows() : get_included_cols();
+}
+
 //------------------------------------------------------------------------------
 // Returns the number of rows kept in the best solution.
 //------------------------------------------------------------------------------
 std::size_t AddRowGreedy::get_num_rows_to_keep() const {
-  return best_num_rows;
+  const std::vector<bool> rows_to_keep = get_rows_to_keep();
+  return std::count(rows_to_keep.begin(), rows_to_keep.end(), true);
+}
+
+//------------------------------------------------------------------------------
+// Returns the number of row inclusions skipped because they could not improve
+// the incumbent.
+//------------------------------------------------------------------------------
+std::size_t AddRowGreedy::get_num_pruned_iterations() const {
+  return num_pruned_iterations;
 }
 
 //------------------------------------------------------------------------------
 // Returns the number of columns kept in the best solution.
 //------------------------------------------------------------------------------
 std::size_t AddRowGreedy::get_num_cols_to_keep() const {
-  std::size_t num_cols_to_keep = num_cols;
+  const std::vector<bool> cols_to_keep = get_cols_to_keep();
+  return std::count(cols_to_keep.begin(), cols_to_keep.end(), true);
+}
 
-  for (std::size_t j = 0; j < num_cols; ++j) {
-    for (std::size_t k = 0; k < best_num_rows; ++k) {
-      std::size_t i = included_rows[k];
-      if (data->is_data_na(i,j)) {
-        --num_cols_to_keep;
-        break;
-      }
-    }
-  }
+//------------------------------------------------------------------------------
+// Returns the rows of the solver in the order they were included.
+//------------------------------------------------------------------------------
+const std::vector<std::size_t> &AddRowGreedy::get_row_order() const {
+  return included_rows;
+}
 
-  return num_cols_to_keep;
+//------------------------------------------------------------------------------
+// Returns the number of included columns after each inclusion. Empty unless
+// the trajectory was recorded.
+//------------------------------------------------------------------------------
+const std::vector<std::size_t> &AddRowGreedy::get_num_cols_by_step() const {
+  return num_cols_by_step;
 }
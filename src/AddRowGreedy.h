@@ -1,12 +1,21 @@
 #ifndef ADD_ROW_GREEDY_H
 #define ADD_ROW_GREEDY_H
 
+#include <atomic>
+#include <cstdint>
 #include <vector>
 #include "BinContainer.h"
 
+//------------------------------------------------------------------------------
+// Add-row greedy solver for no missing data. With 'transpose' set, the rows
+// the solver adds are the data's columns, read from the column-major words, so
+// the solver's rows and columns are the data's columns and rows. The solution
+// getters always refer to the data's rows and columns.
+//------------------------------------------------------------------------------
 class AddRowGreedy {
 private:
   const BinContainer *data;
+  const bool transpose;
   const std::size_t num_rows;
   const std::size_t num_cols;
   const std::size_t row_lb;
@@ -14,18 +23,81 @@ private:
 
   std::size_t best_obj_value;
   std::size_t best_num_rows;
+  std::size_t num_pruned_iterations;
 
-  std::vector<bool> columns;
+  // Order of rows on ties, the lowest index first when empty, and the best
+  // objective of other solvers, if shared
+  std::vector<std::size_t> row_rank;
+  const std::atomic<std::size_t> *incumbent;
+
+  // Included columns after each inclusion, kept when the trajectory is
+  // recorded
+  bool recording;
+  std::vector<std::size_t> num_cols_by_step;
+
+  std::vector<uint64_t> included_cols;
   std::size_t num_included_cols;
   std::vector<std::size_t> alphas;
-  std::vector<std::size_t> excluded_rows;
+  std::vector<uint64_t> excluded_rows;
+  std::size_t num_excluded_rows;
   std::vector<std::size_t> included_rows;
 
+  // Excluded rows bucketed by alpha. Alphas only decrease, so the highest
+  // non-empty bucket only moves down.
+  std::vector<std::vector<std::size_t>> alpha_buckets;
+  std::vector<std::size_t> bucket_pos;
+  std::size_t best_alpha;
+
+  // Per column tie-breaking statistics, reset after each selection
+  std::vector<std::size_t> col_num_miss;
+  std::vector<std::size_t> col_alpha_sum;
+  std::vector<std::size_t> touched_cols;
+
+  // Included columns missing in a candidate row
+  std::vector<uint64_t> candidate_cols;
+
+  // Row bit masks of the buckets with alphas in [window_alpha - 2,
+  // window_alpha], the mask of alpha a at near_rows[a % 3]. They are kept up
+  // to date as rows move between buckets, and the window follows best_alpha
+  // down.
+  std::vector<std::vector<uint64_t>> near_rows;
+  std::size_t window_alpha;
+
+  const uint64_t *get_row_words(const std::size_t i) const {
+    return transpose ? data->get_col_words(i) : data->get_row_words(i);
+  }
+  const uint64_t *get_col_words(const std::size_t j) const {
+    return transpose ? data->get_row_words(j) : data->get_col_words(j);
+  }
+  std::size_t get_num_row_words() const {
+    return transpose ? data->get_num_col_words() : data->get_num_row_words();
+  }
+  std::size_t get_num_col_words() const {
+    return transpose ? data->get_num_row_words() : data->get_num_col_words();
+  }
+
   std::size_t calc_obj() const;
+  bool can_improve() const;
+  bool can_beat(const std::size_t bound) const;
 
   std::size_t get_next_row();
+  void count_missing_by_rows(const std::size_t lowest_alpha);
+  void count_missing_by_cols(const std::size_t lowest_alpha);
   void include_row(const std::size_t row);
   void update_alphas(const std::size_t row);
+  void add_to_bucket(const std::size_t row);
+  void remove_from_bucket(const std::size_t row);
+  bool is_in_window(const std::size_t alpha) const;
+  void slide_window();
+
+  std::vector<bool> get_included_rows() const;
+  std::vector<bool> get_included_cols() const;
+
+protected:
+  AddRowGreedy(const BinContainer &_data,
+               const std::size_t _row_lb,
+               const std::size_t _col_lb,
+               const bool _transpose);
 
 public:
   AddRowGreedy(const BinContainer &_data,
@@ -33,12 +105,19 @@ public:
                const std::size_t _col_lb);
   ~AddRowGreedy();
 
+  void record_trajectory();
+  void randomize_ties(const uint64_t seed);
+  void set_incumbent(const std::atomic<std::size_t> *_incumbent);
   void solve();
 
+  bool has_solution() const;
   std::vector<bool> get_rows_to_keep() const;
   std::vector<bool> get_cols_to_keep() const;
   std::size_t get_num_rows_to_keep() const;
   std::size_t get_num_cols_to_keep() const;
+  std::size_t get_num_pruned_iterations() const;
+  const std::vector<std::size_t> &get_row_order() const;
+  const std::vector<std::size_t> &get_num_cols_by_step() const;
 };
 
 #endif
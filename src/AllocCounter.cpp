@@ -0,0 +1,63 @@
+#include "AllocCounter.h"
+#include <cstdlib>
+#include <new>
+
+namespace {
+  thread_local std::size_t thread_count = 0;
+}
+
+std::size_t alloc_counter::get_thread_count() {
+  return thread_count;
+}
+
+#ifdef MRCLEAN_COUNT_ALLOCATIONS
+namespace {
+  void *allocate(std::size_t size) {
+    ++thread_count;
+    if (size == 0) {
+      size = 1;
+    }
+    return std::malloc(size);
+  }
+}
+
+void *operator new(std::size_t size) {
+  void *p = allocate(size);
+  if (p == nullptr) {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+
+void *operator new[](std::size_t size) {
+  void *p = allocate(size);
+  if (p == nullptr) {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept {
+  return allocate(size);
+}
+
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept {
+  return allocate(size);
+}
+
+void operator delete(void *p) noexcept {
+  std::free(p);
+}
+
+void operator delete[](void *p) noexcept {
+  std::free(p);
+}
+
+void operator delete(void *p, const std::nothrow_t &) noexcept {
+  std::free(p);
+}
+
+void operator delete[](void *p, const std::nothrow_t &) noexcept {
+  std::free(p);
+}
+#endif
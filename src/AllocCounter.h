@@ -0,0 +1,17 @@
+#ifndef ALLOC_COUNTER_H
+#define ALLOC_COUNTER_H
+
+#include <cstddef>
+
+//------------------------------------------------------------------------------
+// Counts heap allocations. When built with MRCLEAN_COUNT_ALLOCATIONS (make
+// bench), AllocCounter.cpp replaces the global operator new, which increments
+// a per-thread counter before forwarding to malloc. Otherwise the count is
+// always 0.
+//------------------------------------------------------------------------------
+namespace alloc_counter {
+  // Number of heap allocations made by the calling thread so far
+  std::size_t get_thread_count();
+}
+
+#endif
@@ -1,95 +1,255 @@
 #include "BinContainer.h"
-#include <fstream>
-#include <sstream>
 #include <algorithm>
+#include <stdexcept>
+#include <thread>
+#include "FileWriter.h"
+#include "GzipReader.h"
+#include "GzipWriter.h"
+#include "MappedFile.h"
+#include "MaskCache.h"
+#include "MrCleanUtils.h"
+#include "ParallelWriter.h"
+#include "PopcountKernels.h"
 
 BinContainer::BinContainer(const std::string &_file_name,
                            const std::string &_na_symbol,
                            const std::size_t _num_header_rows,
-                           const std::size_t _num_header_cols) :  file_name(_file_name),
-                                                                  na_symbol(_na_symbol),
-                                                                  num_header_rows(_num_header_rows),
-                                                                  num_header_cols(_num_header_cols) {
+                           const std::size_t _num_header_cols,
+                           const std::size_t _num_threads,
+                           const char _delim,
+                           const std::string &_cache_dir) : file_name(_file_name),
+                                                            na_symbol(_na_symbol),
+                                                            num_header_rows(_num_header_rows),
+                                                            num_header_cols(_num_header_cols),
+                                                            num_threads(std::max<std::size_t>(1, _num_threads)),
+                                                            scanner(_delim),
+                                                            cache_dir(_cache_dir),
+                                                            loaded_from_cache(false) {
   read();
 }
 
 BinContainer::~BinContainer() {}
 
 void BinContainer::read() {
-  std::string line;
-  std::ifstream input;
-
-  input.open(file_name.c_str());
-  if (!input)
+  MappedFile input(file_name);
+  if (!input.is_open())
     throw std::runtime_error("Input file could not be opened.");
-  
-  // Determine the number of rows
-  const std::size_t num_rows = std::count(std::istreambuf_iterator<char>(input),
-                                          std::istreambuf_iterator<char>(), '\n');
-
-  // Determine the number of columns
-  input.seekg(std::ios_base::beg);  // Go to beginning of file
-  std::getline(input, line); // Read in first line
-  // const std::size_t num_cols = std::count(line.begin(), line.end(), '\t') + 1;
-  std::size_t num_cols = 0;
-    std::istringstream iss(line);
-    std::string token;
-    while (!iss.eof()) {
-      std::getline(iss, token, '\t');
-      if (!token.empty()) {
-        ++num_cols;
-      }
+  if (input.get_size() == 0)
+    throw std::runtime_error("Input file is empty.");
+
+  // Gzip compressed files are decompressed as they are parsed
+  const bool compressed = GzipReader::is_gzip_file(file_name);
+
+  if (cache_dir.empty()) {
+    if (compressed) {
+      parse_stream();
+    } else {
+      parse(input.begin(), input.end());
     }
+    data.build_col_major();
+    return;
+  }
+
+  // Reuse the mask from an earlier parse of the same file when possible
+  MaskCache cache(cache_dir, file_name, na_symbol, num_header_rows, num_header_cols, scanner.get_delim());
+  if (cache.load(data, line_offsets)) {
+    loaded_from_cache = true;
+    return;
+  }
 
-  const std::size_t num_data_rows = num_rows - num_header_rows;
-  const std::size_t num_data_cols = num_cols - num_header_cols;
+  if (compressed) {
+    parse_stream();
+  } else {
+    parse(input.begin(), input.end());
+  }
+  data.build_col_major();
+  if (!cache.save(data, line_offsets)) {
+    fprintf(stderr, "WARNING - Could not write mask cache (%s).\n", cache.get_cache_file().c_str());
+  }
+}
 
-  // fprintf(stderr, "Num rows: %lu\n", num_rows);
-  // fprintf(stderr, "Num cols: %lu\n", num_cols);
+std::size_t BinContainer::count_data_cols(const char *begin, const char *end) const {
+  // Determine the number of columns from the first line
+  std::size_t num_cols = 0;
+  const char *token = begin;
+  while (true) {
+    const char *field_end = scanner.find_field_end(token, end);
+    if (field_end != token) {
+      ++num_cols;
+    }
+    if (field_end == end || *field_end == '\n') {
+      break;
+    }
+    token = field_end + 1;
+  }
 
-  // Allocate memory
-  std::vector<bool> data_row(num_data_cols);
-  for (std::size_t i = 0; i < num_data_rows; ++i) {
-    data.push_back(data_row);
+  if (num_cols < num_header_cols) {
+    throw std::runtime_error("Input file has fewer columns than header columns.");
   }
-  // fprintf(stderr, "Allocated memory\n");
+  return num_cols - num_header_cols;
+}
 
-  // Read in data
-  input.seekg(std::ios_base::beg);  // Go to beginning of file
+void BinContainer::parse(const char *begin, const char *end) {
+  const std::size_t num_data_cols = count_data_cols(begin, end);
+
+  // Skip header rows
+  const char *data_begin = begin;
   for (std::size_t i = 0; i < num_header_rows; ++i) {
-    std::getline(input, line);
+    if (data_begin >= end) {
+      throw std::runtime_error("Input file has fewer lines than header rows.");
+    }
+    data_begin = std::min(end, scanner.find_line_end(data_begin, end) + 1);
   }
 
-  for (std::size_t i = 0; i < num_data_rows; ++i) {
-    std::getline(input, line);
+  if (num_threads > 1) {
+    parse_rows_parallel(begin, data_begin, end, num_data_cols);
+  } else {
+    parse_rows(begin, data_begin, end, num_data_cols);
+  }
+}
 
-    std::istringstream iss(line);
-    std::string token;
-    for (std::size_t j = 0; j < num_header_cols; ++j) {
-      std::getline(iss, token, '\t');
+void BinContainer::parse_stream() {
+  GzipReader input(file_name);
+  if (!input.is_open())
+    throw std::runtime_error("Input file could not be opened.");
+
+  const char *begin;
+  const char *end;
+  uint64_t offset;
+  if (!input.next_chunk(begin, end, offset))
+    throw std::runtime_error("Input file is empty.");
+
+  // Chunks hold whole lines, so the first line is in the first chunk. The
+  // line offsets are positions in the decompressed data.
+  data.resize(0, count_data_cols(begin, end));
+  line_offsets.clear();
+
+  std::size_t num_skipped = 0;
+  uint64_t data_end = 0;
+  do {
+    const char *line = begin;
+    for (; num_skipped < num_header_rows && line < end; ++num_skipped) {
+      line = std::min(end, scanner.find_line_end(line, end) + 1);
     }
-    for (std::size_t j = 0; j < num_data_cols; ++j) {
-      std::getline(iss, token, '\t');
-      token = trim(token);
-
-      if (token.compare(na_symbol) == 0) {
-        data[i][j] = false;
-      } else {
-        data[i][j] = true;
-      }
+    while (line < end) {
+      line_offsets.push_back(offset + (line - begin));
+      line = parse_data_row(line, end, data.append_row());
     }
+    data_end = offset + (end - begin);
+  } while (input.next_chunk(begin, end, offset));
+
+  if (num_skipped < num_header_rows) {
+    throw std::runtime_error("Input file has fewer lines than header rows.");
+  }
+  line_offsets.push_back(data_end);
+}
+
+void BinContainer::parse_rows(const char *base,
+                              const char *begin,
+                              const char *end,
+                              const std::size_t num_data_cols) {
+  // Single forward scan over the data lines. The mask grows by one row for
+  // each line, so the number of rows never has to be counted up front. The
+  // byte offset of each line is recorded, followed by that of the end of the
+  // data.
+  data.resize(0, num_data_cols);
+  line_offsets.clear();
+
+  const char *line = begin;
+  while (line < end) {
+    line_offsets.push_back(line - base);
+    line = parse_data_row(line, end, data.append_row());
+  }
+  line_offsets.push_back(std::min(line, end) - base);
+}
+
+void BinContainer::parse_rows_parallel(const char *base,
+                                       const char *begin,
+                                       const char *end,
+                                       const std::size_t num_data_cols) {
+  // Keep chunks large enough that thread start-up is not the dominant cost
+  const std::size_t min_chunk_size = 1 << 16;
+  const std::size_t size = end - begin;
+  const std::size_t num_chunks = std::max<std::size_t>(1, std::min(num_threads, size / min_chunk_size));
+
+  if (num_chunks == 1) {
+    parse_rows(base, begin, end, num_data_cols);
+    return;
+  }
+
+  // Split the data at newline boundaries so every chunk holds whole lines
+  std::vector<const char *> bounds(num_chunks + 1, end);
+  bounds[0] = begin;
+  for (std::size_t k = 1; k < num_chunks; ++k) {
+    const char *guess = std::max(bounds[k - 1], begin + k * (size / num_chunks));
+    bounds[k] = std::min(end, scanner.find_line_end(guess, end) + 1);
+  }
+
+  // Count the lines in each chunk
+  std::vector<std::size_t> chunk_rows(num_chunks, 0);
+  std::vector<std::thread> workers;
+  for (std::size_t k = 0; k < num_chunks; ++k) {
+    workers.emplace_back([&, k]() {
+      std::size_t count = std::count(bounds[k], bounds[k + 1], '\n');
+      if (bounds[k + 1] == end && bounds[k] < end && *(end - 1) != '\n') {
+        ++count; // Unterminated final line
+      }
+      chunk_rows[k] = count;
+    });
+  }
+  for (auto &w : workers) {
+    w.join();
   }
+  workers.clear();
 
-  input.close();
+  // Prefix sum gives the first mask row of each chunk
+  std::vector<std::size_t> first_row(num_chunks + 1, 0);
+  for (std::size_t k = 0; k < num_chunks; ++k) {
+    first_row[k + 1] = first_row[k] + chunk_rows[k];
+  }
+  data.resize(first_row[num_chunks], num_data_cols);
+  line_offsets.assign(first_row[num_chunks] + 1, 0);
+  line_offsets[first_row[num_chunks]] = end - base;
+
+  // Each worker fills a disjoint range of rows
+  for (std::size_t k = 0; k < num_chunks; ++k) {
+    workers.emplace_back([&, k]() {
+      std::size_t i = first_row[k];
+      const char *line = bounds[k];
+      while (line < bounds[k + 1]) {
+        line_offsets[i] = line - base;
+        line = parse_data_row(line, bounds[k + 1], data.get_row_words(i++));
+      }
+    });
+  }
+  for (auto &w : workers) {
+    w.join();
+  }
 }
 
-std::string BinContainer::trim(std::string &str) const {
-  size_t first = str.find_first_not_of(' ');
-  if (std::string::npos == first) {
-    return str;
+const char *BinContainer::parse_data_row(const char *line,
+                                         const char *end,
+                                         uint64_t *row) const {
+  const char *token = line;
+
+  // Skip header columns
+  for (std::size_t j = 0; j < num_header_cols; ++j) {
+    token = scanner.next_field(scanner.find_field_end(token, end), end);
+  }
+
+  // Set the bit of every valid element. Fields missing from a short line are
+  // treated as empty tokens.
+  const std::size_t num_data_cols = data.get_num_cols();
+  for (std::size_t j = 0; j < num_data_cols; ++j) {
+    const char *field_end = scanner.find_field_end(token, end);
+    if (!DelimScanner::is_token(token, field_end, na_symbol)) {
+      mr_clean_utils::set_bit(row, j);
+    }
+    token = scanner.next_field(field_end, end);
   }
-  size_t last = str.find_last_not_of(' ');
-  return str.substr(first, (last - first + 1));
+
+  // Return the start of the next line
+  return std::min(end, scanner.find_line_end(token, end) + 1);
 }
 
 std::size_t BinContainer::get_num_header_rows() const {
@@ -101,11 +261,11 @@ std::size_t BinContainer::get_num_header_cols() const {
 }
 
 std::size_t BinContainer::get_num_data_rows() const {
-  return data.size();
+  return data.get_num_rows();
 }
 
 std::size_t BinContainer::get_num_data_cols() const {
-  return data.empty() ? 0 : data[0].size();
+  return data.get_num_cols();
 }
 
 std::size_t BinContainer::get_num_data() const {
@@ -115,11 +275,7 @@ std::size_t BinContainer::get_num_data() const {
 std::size_t BinContainer::get_num_valid_data() const {
   std::size_t count = 0;
   for (std::size_t i = 0; i < get_num_data_rows(); ++i) {
-    for (std::size_t j = 0; j < get_num_data_cols(); ++j) {
-      if (data[i][j]) {
-        ++count;
-      }
-    }
+    count += popcount_kernels::count(data.get_row_words(i), data.get_num_row_words());
   }
   return count;
 }
@@ -137,15 +293,20 @@ std::size_t BinContainer::get_num_valid_data_kept(const std::vector<bool> &keep_
     exit(EXIT_FAILURE);
   }
 
-  std::size_t count = 0;
-  for (std::size_t i = 0; i < get_num_data_rows(); ++i) {
-    for (std::size_t j = 0; j < get_num_data_cols(); ++j) {
-      if (keep_row[i] && keep_col[j] && !is_data_na(i, j)) {
-        ++count;
-      }
+  std::vector<uint64_t> row_mask(mr_clean_utils::num_words(keep_row.size()), 0);
+  std::vector<uint64_t> col_mask(mr_clean_utils::num_words(keep_col.size()), 0);
+  for (std::size_t i = 0; i < keep_row.size(); ++i) {
+    if (keep_row[i]) {
+      mr_clean_utils::set_bit(row_mask.data(), i);
+    }
+  }
+  for (std::size_t j = 0; j < keep_col.size(); ++j) {
+    if (keep_col[j]) {
+      mr_clean_utils::set_bit(col_mask.data(), j);
     }
   }
-  return count; 
+
+  return count_valid_kept(row_mask, col_mask);
 }
 
 std::size_t BinContainer::get_num_valid_data_kept(const std::vector<int> &keep_row,
@@ -161,24 +322,102 @@ std::size_t BinContainer::get_num_valid_data_kept(const std::vector<int> &keep_r
     exit(EXIT_FAILURE);
   }
 
-  std::size_t count = 0;
-  for (std::size_t i = 0; i < get_num_data_rows(); ++i) {
-    for (std::size_t j = 0; j < get_num_data_cols(); ++j) {
-      if ((keep_row[i]==1) && (keep_col[j]==1) && !is_data_na(i, j)) {
-        ++count;
-      }
+  std::vector<uint64_t> row_mask(mr_clean_utils::num_words(keep_row.size()), 0);
+  std::vector<uint64_t> col_mask(mr_clean_utils::num_words(keep_col.size()), 0);
+  for (std::size_t i = 0; i < keep_row.size(); ++i) {
+    if (keep_row[i] == 1) {
+      mr_clean_utils::set_bit(row_mask.data(), i);
     }
   }
-  return count; 
+  for (std::size_t j = 0; j < keep_col.size(); ++j) {
+    if (keep_col[j] == 1) {
+      mr_clean_utils::set_bit(col_mask.data(), j);
+    }
+  }
+
+  return count_valid_kept(row_mask, col_mask);
+}
+
+std::size_t BinContainer::count_valid_kept(const std::vector<uint64_t> &row_mask,
+                                           const std::vector<uint64_t> &col_mask) const {
+  if (get_num_data_rows() == 0) {
+    return 0;
+  }
+  return popcount_kernels::count_and_rows(data.get_row_words(0),
+                                          data.get_row_stride(),
+                                          get_num_data_rows(),
+                                          row_mask.data(),
+                                          col_mask.data(),
+                                          data.get_num_row_words());
+}
+
+bool BinContainer::is_loaded_from_cache() const {
+  return loaded_from_cache;
+}
+
+const std::vector<uint64_t> &BinContainer::get_line_offsets() const {
+  return line_offsets;
 }
 
 bool BinContainer::is_data_na(const std::size_t i, const std::size_t j) const {
-  return !data[i][j];
+  return !data.get(i, j);
+}
+
+std::size_t BinContainer::get_num_row_words() const {
+  return data.get_num_row_words();
+}
+
+std::size_t BinContainer::get_num_col_words() const {
+  return data.get_num_col_words();
+}
+
+const uint64_t *BinContainer::get_row_words(const std::size_t i) const {
+  return data.get_row_words(i);
+}
+
+const uint64_t *BinContainer::get_col_words(const std::size_t j) const {
+  return data.get_col_words(j);
+}
+
+void BinContainer::count_valid_in_cols(const std::vector<uint64_t> &row_mask,
+                                       std::vector<std::size_t> &counts) const {
+  counts.resize(get_num_data_cols());
+  if (get_num_data_rows() == 0) {
+    std::fill(counts.begin(), counts.end(), 0);
+    return;
+  }
+  popcount_kernels::count_columns(data.get_row_words(0),
+                                  data.get_row_stride(),
+                                  get_num_data_rows(),
+                                  row_mask.data(),
+                                  get_num_data_cols(),
+                                  counts.data());
+}
+
+namespace {
+  // Appends 'size' input bytes of whole lines starting at 'offset', which are
+  // in memory at 'bytes'. 'in_fd' is -1 when the input is not a plain file.
+  void copy_lines(FileWriter &output, const int in_fd, const uint64_t offset, const uint64_t size, const char *bytes) {
+    output.copy_range(in_fd, offset, size, bytes);
+  }
+
+  void copy_lines(GzipWriter &output, const int, const uint64_t, const uint64_t size, const char *bytes) {
+    output.append(bytes, size);
+  }
+
+  void copy_lines(BlockBuffer &output, const int, const uint64_t, const uint64_t size, const char *bytes) {
+    output.append(bytes, size);
+  }
+
+  bool ends_with(const std::string &s, const std::string &suffix) {
+    return s.size() >= suffix.size() && s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+  }
 }
 
 void BinContainer::write_orig(const std::string &out_file,
                               const std::vector<bool> &rows_to_keep,
-                              const std::vector<bool> &cols_to_keep) const {
+                              const std::vector<bool> &cols_to_keep,
+                              const std::size_t num_write_threads) const {
   if (get_num_data_rows() != rows_to_keep.size()) {
     fprintf(stderr, "ERROR - BinContainer::write_orig - Size of 'rows_to_keep' does not match the number of data rows\n");
     exit(EXIT_FAILURE);
@@ -189,98 +428,239 @@ void BinContainer::write_orig(const std::string &out_file,
   }
 
   const std::size_t num_header_rows = get_num_header_rows();
-  const std::size_t num_header_cols = get_num_header_cols();
   const std::size_t num_data_rows = get_num_data_rows();
-  const std::size_t num_data_cols = get_num_data_cols();
 
-  // fprintf(stderr, "Num header rows: %lu\n", num_header_rows);
-  // fprintf(stderr, "Num header cols: %lu\n", num_header_cols);
-  // fprintf(stderr, "Num data rows: %lu\n", num_data_rows);
-  // fprintf(stderr, "Num data cols: %lu\n", num_data_cols);
+  // An output file name ending in .gz is written gzip compressed
+  const bool compress = ends_with(out_file, ".gz");
 
-  std::string line;
-  std::ifstream input;
+  if (GzipReader::is_gzip_file(file_name)) {
+    if (compress) {
+      GzipWriter output(out_file, num_write_threads);
+      write_orig_stream(output, out_file, rows_to_keep, cols_to_keep);
+    } else {
+      FileWriter output(out_file);
+      write_orig_stream(output, out_file, rows_to_keep, cols_to_keep);
+    }
+    return;
+  }
 
-  input.open(file_name.c_str());
-  if (!input) {
+  MappedFile input(file_name);
+  if (!input.is_open()) {
     fprintf(stderr, "Input file could not be opened.\n");
     exit(EXIT_FAILURE);
   }
 
-  FILE *output;
-  if ((output = fopen(out_file.c_str(), "w")) == nullptr) {
+  if (num_write_threads > 1 || compress) {
+    write_orig_parallel(out_file, input, rows_to_keep, cols_to_keep, num_write_threads, compress);
+    return;
+  }
+
+  FileWriter output(out_file);
+  if (!output.is_open()) {
     fprintf(stderr, "ERROR - Could not open file (%s).\n", out_file.c_str());
     exit(EXIT_FAILURE);
   }
 
-  // Read in data
+  const char *line = input.begin();
   for (std::size_t i = 0; i < num_header_rows; ++i) {
-    std::getline(input, line);
-
-    std::istringstream iss(line);
-    std::string token;
-
-    // Print first header col
-    std::getline(iss, token, '\t');
-    token = trim(token);
-    fprintf(output, "%s", token.c_str());
-    
-    // Print remaining header columns
-    for (std::size_t j = 1; j < num_header_cols; ++j) {
-      std::getline(iss, token, '\t');
-      token = trim(token);
-      fprintf(output, "\t%s", token.c_str());
+    line = write_orig_line(output, line, input.end(), cols_to_keep);
+  }
+  write_orig_rows(output, input.begin(), 0, input.end(), input.get_fd(), 0, num_data_rows, rows_to_keep, cols_to_keep);
+
+  if (!output.close()) {
+    fprintf(stderr, "ERROR - Could not write file (%s).\n", out_file.c_str());
+    exit(EXIT_FAILURE);
+  }
+}
+
+void BinContainer::write_orig_parallel(const std::string &out_file,
+                                       const MappedFile &input,
+                                       const std::vector<bool> &rows_to_keep,
+                                       const std::vector<bool> &cols_to_keep,
+                                       const std::size_t num_write_threads,
+                                       const bool compress) const {
+  ParallelWriter output(out_file, num_write_threads, compress);
+  if (!output.is_open()) {
+    fprintf(stderr, "ERROR - Could not open file (%s).\n", out_file.c_str());
+    exit(EXIT_FAILURE);
+  }
+
+  // Split the data rows into blocks holding about the same number of kept
+  // input bytes. The header lines go at the start of the first block.
+  const uint64_t block_size = 1 << 22;
+  const std::size_t num_data_rows = get_num_data_rows();
+  std::vector<std::size_t> block_rows(1, 0);
+  uint64_t kept_size = 0;
+  for (std::size_t i = 0; i < num_data_rows; ++i) {
+    if (rows_to_keep[i]) {
+      kept_size += line_offsets[i + 1] - line_offsets[i];
     }
+    if (kept_size >= block_size) {
+      block_rows.push_back(i + 1);
+      kept_size = 0;
+    }
+  }
+  if (block_rows.back() != num_data_rows || block_rows.size() == 1) {
+    block_rows.push_back(num_data_rows);
+  }
 
-    // Print data cols if kept
-    for (std::size_t j = 0; j < num_data_cols; ++j) {
-      std::getline(iss, token, '\t');
-      if (cols_to_keep[j]) {
-        token = trim(token);
-        fprintf(output, "\t%s", token.c_str());
+  output.write_blocks(block_rows.size() - 1, [&](std::size_t k, BlockBuffer &buffer) {
+    if (k == 0) {
+      const char *line = input.begin();
+      for (std::size_t i = 0; i < num_header_rows; ++i) {
+        line = write_orig_line(buffer, line, input.end(), cols_to_keep);
       }
     }
-    fprintf(output, "\n");
+    write_orig_rows(buffer, input.begin(), 0, input.end(), input.get_fd(), block_rows[k], block_rows[k + 1],
+                    rows_to_keep, cols_to_keep);
+  });
+
+  if (!output.close()) {
+    fprintf(stderr, "ERROR - Could not write file (%s).\n", out_file.c_str());
+    exit(EXIT_FAILURE);
   }
+}
 
-  for (std::size_t i = 0; i < num_data_rows; ++i) {
-    std::getline(input, line);
+template <class Output>
+void BinContainer::write_orig_stream(Output &output,
+                                     const std::string &out_file,
+                                     const std::vector<bool> &rows_to_keep,
+                                     const std::vector<bool> &cols_to_keep) const {
+  if (!output.is_open()) {
+    fprintf(stderr, "ERROR - Could not open file (%s).\n", out_file.c_str());
+    exit(EXIT_FAILURE);
+  }
+  GzipReader input(file_name);
+  if (!input.is_open()) {
+    fprintf(stderr, "Input file could not be opened.\n");
+    exit(EXIT_FAILURE);
+  }
 
-    if (rows_to_keep[i]) {
-      std::istringstream iss(line);
-      std::string token;
-
-      // Print first header col
-      std::getline(iss, token, '\t');
-      token = trim(token);
-      fprintf(output, "%s", token.c_str());
-
-      // Print remaining header columns
-      for (std::size_t j = 1; j < num_header_cols; ++j) {
-        std::getline(iss, token, '\t');
-        token = trim(token);
-        fprintf(output, "\t%s", token.c_str());
+  // Decompress the input again, one chunk of whole lines at a time, and write
+  // the kept data rows that start in each chunk
+  const char *begin;
+  const char *end;
+  uint64_t offset;
+  std::size_t num_written = 0;
+  std::size_t first_row = 0;
+  while (input.next_chunk(begin, end, offset)) {
+    const char *line = begin;
+    for (; num_written < num_header_rows && line < end; ++num_written) {
+      line = write_orig_line(output, line, end, cols_to_keep);
+    }
+
+    const uint64_t chunk_end = offset + (end - begin);
+    std::size_t last_row = first_row;
+    while (last_row < get_num_data_rows() && line_offsets[last_row] < chunk_end) {
+      ++last_row;
+    }
+    write_orig_rows(output, begin, offset, end, -1, first_row, last_row, rows_to_keep, cols_to_keep);
+    first_row = last_row;
+  }
+
+  if (!output.close()) {
+    fprintf(stderr, "ERROR - Could not write file (%s).\n", out_file.c_str());
+    exit(EXIT_FAILURE);
+  }
+}
+
+template <class Output>
+void BinContainer::write_orig_rows(Output &output,
+                                   const char *chunk,
+                                   const uint64_t chunk_offset,
+                                   const char *end,
+                                   const int in_fd,
+                                   const std::size_t first_row,
+                                   const std::size_t last_row,
+                                   const std::vector<bool> &rows_to_keep,
+                                   const std::vector<bool> &cols_to_keep) const {
+  // Kept data lines are found through the line offsets recorded by the parse.
+  // When every column is kept, a line that is already in output form is
+  // copied verbatim, and consecutive such lines are copied as one range.
+  const bool keep_all_cols = scanner.get_delim() == '\t' &&
+                             std::find(cols_to_keep.begin(), cols_to_keep.end(), false) == cols_to_keep.end();
+  const std::size_t num_fields = num_header_cols + cols_to_keep.size();
+  uint64_t copy_begin = 0;
+  uint64_t copy_end = 0;
+
+  // Line offsets are positions in the whole input, of which [chunk, end)
+  // starts at 'chunk_offset'
+  auto flush_copy = [&]() {
+    if (copy_end > copy_begin) {
+      copy_lines(output, in_fd, copy_begin, copy_end - copy_begin, chunk + (copy_begin - chunk_offset));
+    }
+  };
+
+  for (std::size_t i = first_row; i < last_row; ++i) {
+    if (!rows_to_keep[i]) {
+      continue;
+    }
+    const uint64_t row_begin = line_offsets[i];
+    const uint64_t row_end = line_offsets[i + 1];
+    const char *line = chunk + (row_begin - chunk_offset);
+    if (keep_all_cols && is_output_line(line, line + (row_end - row_begin), num_fields)) {
+      if (row_begin != copy_end) {
+        flush_copy();
+        copy_begin = row_begin;
       }
+      copy_end = row_end;
+    } else {
+      flush_copy();
+      copy_begin = copy_end = 0;
+      write_orig_line(output, line, end, cols_to_keep);
+    }
+  }
+  flush_copy();
+}
 
-      // Print data cols if kept
-      for (std::size_t j = 0; j < num_data_cols; ++j) {
-        std::getline(iss, token, '\t');
-        if (cols_to_keep[j]) {
-          token = trim(token);
-          fprintf(output, "\t%s", token.c_str());
-        }
+template <class Output>
+const char *BinContainer::write_orig_line(Output &output,
+                                          const char *line,
+                                          const char *end,
+                                          const std::vector<bool> &cols_to_keep) const {
+  const char *token = line;
+  bool first_field = true;
+
+  // Print header columns and data cols if kept
+  for (std::size_t j = 0; j < num_header_cols + cols_to_keep.size(); ++j) {
+    const char *field_end = scanner.find_field_end(token, end);
+    if (j < num_header_cols || cols_to_keep[j - num_header_cols]) {
+      const char *first = token;
+      const char *last = field_end;
+      DelimScanner::trim(first, last);
+      if (!first_field) {
+        output.put('\t');
       }
-      fprintf(output, "\n");
+      output.append(first, last - first);
+      first_field = false;
     }
+    token = scanner.next_field(field_end, end);
   }
+  output.put('\n');
 
-  fclose(output);
-  input.close();
+  // Return the start of the next line
+  return std::min(end, scanner.find_line_end(token, end) + 1);
+}
+
+bool BinContainer::is_output_line(const char *line, const char *line_end, const std::size_t num_fields) const {
+  // The line must end in a newline and hold exactly 'num_fields' tab separated
+  // fields with no spaces to trim
+  if (line == line_end || *(line_end - 1) != '\n') {
+    return false;
+  }
+  std::size_t num_tabs = 0;
+  std::size_t num_spaces = 0;
+  for (const char *p = line; p < line_end; ++p) {
+    num_tabs += (*p == '\t');
+    num_spaces += (*p == ' ');
+  }
+  return num_spaces == 0 && num_tabs + 1 == num_fields;
 }
 
 void BinContainer::write_orig(const std::string &out_file,
                               const std::vector<int> &rows_to_keep,
-                              const std::vector<int> &cols_to_keep) const {
+                              const std::vector<int> &cols_to_keep,
+                              const std::size_t num_write_threads) const {
   std::vector<bool> rows_to_keep_bool(rows_to_keep.size(), false);
   std::vector<bool> cols_to_keep_bool(cols_to_keep.size(), false);
 
@@ -295,7 +675,7 @@ void BinContainer::write_orig(const std::string &out_file,
     }
   }
 
-  write_orig(out_file, rows_to_keep_bool, cols_to_keep_bool);
+  write_orig(out_file, rows_to_keep_bool, cols_to_keep_bool, num_write_threads);
 }
 
 void BinContainer::print_stats() const {
@@ -307,22 +687,16 @@ void BinContainer::print_stats() const {
   double total_perc_miss = 0.0;
 
   for (std::size_t i = 0; i < M; ++i) {
-    for (std::size_t j = 0; j < N; ++j) {
-      if (!data[i][j]) {
-        ++perc_miss_row[i];
-        ++total_perc_miss;
-      }
-    }
-    perc_miss_row[i] /= N;
+    const std::size_t num_miss = N - popcount_kernels::count(data.get_row_words(i), data.get_num_row_words());
+    perc_miss_row[i] = static_cast<double>(num_miss) / N;
+    total_perc_miss += num_miss;
   }
 
+  // Column counts come from a single sweep over the row-major words
+  std::vector<std::size_t> num_valid_col;
+  count_valid_in_cols(mr_clean_utils::make_full_mask(M), num_valid_col);
   for (std::size_t j = 0; j < N; ++j) {
-    for (std::size_t i = 0; i < M; ++i) {    
-      if (!data[i][j]) {
-        ++perc_miss_col[j];
-      }
-    }
-    perc_miss_col[j] /= M;
+    perc_miss_col[j] = static_cast<double>(M - num_valid_col[j]) / M;
   }
   
   double min_row = 1.0, min_col = 1.0;
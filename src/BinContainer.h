@@ -1,25 +1,79 @@
 #ifndef BIN_CONTAINER_H
 #define BIN_CONTAINER_H
 
+#include <cstdio>
 #include <string>
 #include <vector>
+#include "BitMatrix.h"
+#include "DelimScanner.h"
+
+class MappedFile;
+
 class BinContainer {
 private:
   const std::string file_name;
   const std::string na_symbol;
   const std::size_t num_header_rows;
   const std::size_t num_header_cols;
+  const std::size_t num_threads;
+  const DelimScanner scanner;
+  const std::string cache_dir;
 
-  std::vector<std::vector<bool>> data;
+  BitMatrix data;
+  std::vector<uint64_t> line_offsets;
+  bool loaded_from_cache;
   
   void read();
-  std::string trim(std::string &str) const;
+  std::size_t count_data_cols(const char *begin, const char *end) const;
+  void parse(const char *begin, const char *end);
+  void parse_stream();
+  void parse_rows(const char *base,
+                  const char *begin,
+                  const char *end,
+                  const std::size_t num_data_cols);
+  void parse_rows_parallel(const char *base,
+                           const char *begin,
+                           const char *end,
+                           const std::size_t num_data_cols);
+  const char *parse_data_row(const char *line, const char *end, uint64_t *row) const;
+  std::size_t count_valid_kept(const std::vector<uint64_t> &row_mask,
+                               const std::vector<uint64_t> &col_mask) const;
+  void write_orig_parallel(const std::string &out_file,
+                           const MappedFile &input,
+                           const std::vector<bool> &rows_to_keep,
+                           const std::vector<bool> &cols_to_keep,
+                           const std::size_t num_write_threads,
+                           const bool compress) const;
+  template <class Output>
+  void write_orig_stream(Output &output,
+                         const std::string &out_file,
+                         const std::vector<bool> &rows_to_keep,
+                         const std::vector<bool> &cols_to_keep) const;
+  template <class Output>
+  void write_orig_rows(Output &output,
+                       const char *chunk,
+                       const uint64_t chunk_offset,
+                       const char *end,
+                       const int in_fd,
+                       const std::size_t first_row,
+                       const std::size_t last_row,
+                       const std::vector<bool> &rows_to_keep,
+                       const std::vector<bool> &cols_to_keep) const;
+  template <class Output>
+  const char *write_orig_line(Output &output,
+                              const char *line,
+                              const char *end,
+                              const std::vector<bool> &cols_to_keep) const;
+  bool is_output_line(const char *line, const char *line_end, const std::size_t num_fields) const;
 
 public:  
   BinContainer(const std::string &_file_name,
                const std::string &_na_symbol,
                const std::size_t _num_header_rows = 1,
-               const std::size_t _num_header_cols = 1);
+               const std::size_t _num_header_cols = 1,
+               const std::size_t _num_threads = 1,
+               const char _delim = '\t',
+               const std::string &_cache_dir = "");
   ~BinContainer();
 
   std::size_t get_num_header_rows() const;
@@ -28,6 +82,8 @@ public:
   std::size_t get_num_data_cols() const;
   std::size_t get_num_data() const;
   std::size_t get_num_valid_data() const;
+  bool is_loaded_from_cache() const;
+  const std::vector<uint64_t> &get_line_offsets() const;
   std::size_t get_num_valid_data_kept(const std::vector<bool> &keep_row,
                                       const std::vector<bool> &keep_col) const;
   std::size_t get_num_valid_data_kept(const std::vector<int> &keep_row,
@@ -35,12 +91,21 @@ public:
 
   bool is_data_na(const std::size_t i, const std::size_t j) const;
 
+  std::size_t get_num_row_words() const;
+  std::size_t get_num_col_words() const;
+  const uint64_t *get_row_words(const std::size_t i) const;
+  const uint64_t *get_col_words(const std::size_t j) const;
+  void count_valid_in_cols(const std::vector<uint64_t> &row_mask,
+                           std::vector<std::size_t> &counts) const;
+
   void write_orig(const std::string &out_file,
                   const std::vector<bool> &rows_to_keep,
-                  const std::vector<bool> &cols_to_keep) const;
+                  const std::vector<bool> &cols_to_keep,
+                  const std::size_t num_write_threads = 1) const;
   void write_orig(const std::string &out_file,
                   const std::vector<int> &rows_to_keep,
-                  const std::vector<int> &cols_to_keep) const;
+                  const std::vector<int> &cols_to_keep,
+                  const std::size_t num_write_threads = 1) const;
   
   void print_stats() const;
 };
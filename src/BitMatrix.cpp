@@ -0,0 +1,213 @@
+#include "BitMatrix.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include "MrCleanUtils.h"
+
+//------------------------------------------------------------------------------
+// Constructor.
+//------------------------------------------------------------------------------
+BitMatrix::BitMatrix() : num_rows(0),
+                         num_cols(0),
+                         row_stride(0),
+                         col_stride(0),
+                         row_capacity(0),
+                         row_bits(nullptr),
+                         col_bits(nullptr) {}
+
+//------------------------------------------------------------------------------
+// Destructor.
+//------------------------------------------------------------------------------
+BitMatrix::~BitMatrix() {
+  free(row_bits);
+  free(col_bits);
+}
+
+//------------------------------------------------------------------------------
+// Returns the number of words used to store 'num_bits' bits, rounded up to a
+// whole number of 64-byte cache lines.
+//------------------------------------------------------------------------------
+std::size_t BitMatrix::calc_stride(const std::size_t num_bits) {
+  return (mr_clean_utils::num_words(num_bits) + 7) & ~static_cast<std::size_t>(7);
+}
+
+//------------------------------------------------------------------------------
+// Allocates 'num_words' zeroed words on a 64-byte boundary.
+//------------------------------------------------------------------------------
+uint64_t *BitMatrix::allocate(const std::size_t num_words) {
+  void *ptr = nullptr;
+  if (posix_memalign(&ptr, 64, std::max<std::size_t>(1, num_words) * sizeof(uint64_t)) != 0) {
+    throw std::bad_alloc();
+  }
+  memset(ptr, 0, num_words * sizeof(uint64_t));
+  return static_cast<uint64_t *>(ptr);
+}
+
+//------------------------------------------------------------------------------
+// Sets the dimensions of the matrix and clears all bits.
+//------------------------------------------------------------------------------
+void BitMatrix::resize(const std::size_t _num_rows, const std::size_t _num_cols) {
+  free(row_bits);
+  free(col_bits);
+  col_bits = nullptr;
+
+  num_rows = _num_rows;
+  num_cols = _num_cols;
+  row_stride = calc_stride(num_cols);
+  col_stride = calc_stride(num_rows);
+  row_capacity = num_rows;
+  row_bits = allocate(row_capacity * row_stride);
+}
+
+//------------------------------------------------------------------------------
+// Adds a cleared row to the end of the matrix and returns its words. Storage
+// grows geometrically, so rows can be appended while the input is scanned.
+// The column-major copy must be rebuilt afterwards.
+//------------------------------------------------------------------------------
+uint64_t *BitMatrix::append_row() {
+  if (num_rows == row_capacity) {
+    const std::size_t new_capacity = std::max<std::size_t>(64, 2 * row_capacity);
+    uint64_t *new_bits = allocate(new_capacity * row_stride);
+    if (row_bits != nullptr) {
+      memcpy(new_bits, row_bits, num_rows * row_stride * sizeof(uint64_t));
+      free(row_bits);
+    }
+    row_bits = new_bits;
+    row_capacity = new_capacity;
+  }
+  return row_bits + (num_rows++) * row_stride;
+}
+
+//------------------------------------------------------------------------------
+// Builds the column-major copy by transposing 64 x 64 bit blocks.
+//------------------------------------------------------------------------------
+void BitMatrix::build_col_major() {
+  free(col_bits);
+  col_stride = calc_stride(num_rows);
+  col_bits = allocate(num_cols * col_stride);
+
+  const std::size_t num_row_blocks = mr_clean_utils::num_words(num_rows);
+  const std::size_t num_col_blocks = mr_clean_utils::num_words(num_cols);
+  uint64_t block[64];
+
+  for (std::size_t rb = 0; rb < num_row_blocks; ++rb) {
+    const std::size_t rows_in_block = std::min<std::size_t>(64, num_rows - rb * 64);
+    for (std::size_t cb = 0; cb < num_col_blocks; ++cb) {
+      for (std::size_t r = 0; r < 64; ++r) {
+        block[r] = (r < rows_in_block) ? row_bits[(rb * 64 + r) * row_stride + cb] : 0;
+      }
+      transpose_block(block);
+
+      const std::size_t cols_in_block = std::min<std::size_t>(64, num_cols - cb * 64);
+      for (std::size_t c = 0; c < cols_in_block; ++c) {
+        col_bits[(cb * 64 + c) * col_stride + rb] = block[c];
+      }
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Sets the dimensions of the matrix and copies both layouts from 'num_rows' *
+// get_row_stride() row-major words and 'num_cols' * get_col_stride()
+// column-major words, for example from a mask cache file.
+//------------------------------------------------------------------------------
+void BitMatrix::assign(const std::size_t _num_rows,
+                       const std::size_t _num_cols,
+                       const uint64_t *_row_bits,
+                       const uint64_t *_col_bits) {
+  resize(_num_rows, _num_cols);
+  memcpy(row_bits, _row_bits, num_rows * row_stride * sizeof(uint64_t));
+  col_bits = allocate(num_cols * col_stride);
+  memcpy(col_bits, _col_bits, num_cols * col_stride * sizeof(uint64_t));
+}
+
+//------------------------------------------------------------------------------
+// Transposes a 64 x 64 bit block in place, where bit c of block[r] is element
+// (r, c). Swaps progressively smaller off-diagonal sub-blocks.
+//------------------------------------------------------------------------------
+void BitMatrix::transpose_block(uint64_t block[64]) {
+  uint64_t mask = 0x00000000FFFFFFFFULL;
+  for (std::size_t j = 32; j != 0; j >>= 1, mask ^= (mask << j)) {
+    for (std::size_t k = 0; k < 64; k = ((k | j) + 1) & ~j) {
+      const uint64_t t = ((block[k] >> j) ^ block[k | j]) & mask;
+      block[k] ^= (t << j);
+      block[k | j] ^= t;
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Returns the number of rows.
+//------------------------------------------------------------------------------
+std::size_t BitMatrix::get_num_rows() const {
+  return num_rows;
+}
+
+//------------------------------------------------------------------------------
+// Returns the number of columns.
+//------------------------------------------------------------------------------
+std::size_t BitMatrix::get_num_cols() const {
+  return num_cols;
+}
+
+//------------------------------------------------------------------------------
+// Returns the number of words that hold the bits of one row.
+//------------------------------------------------------------------------------
+std::size_t BitMatrix::get_num_row_words() const {
+  return mr_clean_utils::num_words(num_cols);
+}
+
+//------------------------------------------------------------------------------
+// Returns the number of words that hold the bits of one column.
+//------------------------------------------------------------------------------
+std::size_t BitMatrix::get_num_col_words() const {
+  return mr_clean_utils::num_words(num_rows);
+}
+
+//------------------------------------------------------------------------------
+// Returns the distance in words between the starts of consecutive rows.
+//------------------------------------------------------------------------------
+std::size_t BitMatrix::get_row_stride() const {
+  return row_stride;
+}
+
+//------------------------------------------------------------------------------
+// Returns the distance in words between the starts of consecutive columns.
+//------------------------------------------------------------------------------
+std::size_t BitMatrix::get_col_stride() const {
+  return col_stride;
+}
+
+//------------------------------------------------------------------------------
+// Returns the words of row 'i'.
+//------------------------------------------------------------------------------
+uint64_t *BitMatrix::get_row_words(const std::size_t i) {
+  return row_bits + i * row_stride;
+}
+
+const uint64_t *BitMatrix::get_row_words(const std::size_t i) const {
+  return row_bits + i * row_stride;
+}
+
+//------------------------------------------------------------------------------
+// Returns the words of column 'j'. Only valid after build_col_major().
+//------------------------------------------------------------------------------
+const uint64_t *BitMatrix::get_col_words(const std::size_t j) const {
+  return col_bits + j * col_stride;
+}
+
+//------------------------------------------------------------------------------
+// Returns all row-major words, get_num_rows() * get_row_stride() in total.
+//------------------------------------------------------------------------------
+const uint64_t *BitMatrix::get_row_major() const {
+  return row_bits;
+}
+
+//------------------------------------------------------------------------------
+// Returns all column-major words, get_num_cols() * get_col_stride() in total.
+// Only valid after build_col_major().
+//------------------------------------------------------------------------------
+const uint64_t *BitMatrix::get_col_major() const {
+  return col_bits;
+}
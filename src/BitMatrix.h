@@ -0,0 +1,61 @@
+#ifndef BIT_MATRIX_H
+#define BIT_MATRIX_H
+
+#include <cstdint>
+#include <cstddef>
+
+//------------------------------------------------------------------------------
+// Contiguous bit-packed matrix stored twice: once row-major and once
+// column-major. Bit j of row i is bit (j % 64) of word (j / 64) of that row.
+// Every row and column starts on a 64-byte boundary and padding bits are zero,
+// so rows and columns can be scanned a word at a time. The column-major copy
+// is built from the row-major one by build_col_major().
+//------------------------------------------------------------------------------
+class BitMatrix {
+private:
+  std::size_t num_rows;
+  std::size_t num_cols;
+  std::size_t row_stride;
+  std::size_t col_stride;
+  std::size_t row_capacity;
+  uint64_t *row_bits;
+  uint64_t *col_bits;
+
+  static uint64_t *allocate(const std::size_t num_words);
+  static void transpose_block(uint64_t block[64]);
+
+public:
+  BitMatrix();
+  ~BitMatrix();
+
+  BitMatrix(const BitMatrix &) = delete;
+  BitMatrix &operator=(const BitMatrix &) = delete;
+
+  void resize(const std::size_t _num_rows, const std::size_t _num_cols);
+  uint64_t *append_row();
+  void build_col_major();
+  void assign(const std::size_t _num_rows,
+              const std::size_t _num_cols,
+              const uint64_t *_row_bits,
+              const uint64_t *_col_bits);
+
+  std::size_t get_num_rows() const;
+  std::size_t get_num_cols() const;
+  std::size_t get_num_row_words() const;
+  std::size_t get_num_col_words() const;
+  std::size_t get_row_stride() const;
+  std::size_t get_col_stride() const;
+  static std::size_t calc_stride(const std::size_t num_bits);
+
+  uint64_t *get_row_words(const std::size_t i);
+  const uint64_t *get_row_words(const std::size_t i) const;
+  const uint64_t *get_col_words(const std::size_t j) const;
+  const uint64_t *get_row_major() const;
+  const uint64_t *get_col_major() const;
+
+  bool get(const std::size_t i, const std::size_t j) const {
+    return (row_bits[i * row_stride + (j >> 6)] >> (j & 63)) & 1;
+  }
+};
+
+#endif
@@ -1,9 +1,11 @@
-#include <fstream>
-#include <sstream>
 #include <algorithm>
+#include <stdexcept>
 #include <assert.h>
 
 #include "DataContainer.h"
+#include "DelimScanner.h"
+#include "MappedFile.h"
+#include "ParallelWriter.h"
 
 //------------------------------------------------------------------------------
 // Constructor.
@@ -11,8 +13,9 @@
 DataContainer::DataContainer(const std::string &file_name,
                              const std::string &_na_symbol,
                              const std::size_t num_header_rows,
-                             const std::size_t num_header_cols ) :  na_symbol(_na_symbol) {
-  read(file_name, num_header_rows, num_header_cols);
+                             const std::size_t num_header_cols,
+                             const char delim) :  na_symbol(_na_symbol) {
+  read(file_name, num_header_rows, num_header_cols, delim);
   calc_num_valid();
 }
 
@@ -85,78 +88,65 @@ std::size_t DataContainer::get_num_valid_data() const {
 
 //------------------------------------------------------------------------------
 // Reads in the data file given by 'file_name'. Throws an error if file does
-// not exit. Expects elements in file to be seperated with a tab ('\t'). Number
-// of header rows and columns defaults to 1 in the header file.
+// not exit. Expects elements in file to be seperated by 'delim' (a tab by
+// default). Number of header rows and columns defaults to 1 in the header file.
 //------------------------------------------------------------------------------
 void DataContainer::read(const std::string &file_name,
                          const std::size_t num_header_rows,
-                         const std::size_t num_header_cols)
+                         const std::size_t num_header_cols,
+                         const char delim)
 {
-  std::string line;
-  std::ifstream input;
-
-  input.open(file_name.c_str());
-  if (!input)
+  MappedFile input(file_name);
+  if (!input.is_open())
     throw std::runtime_error("Input file could not be opened.");
-  
+
+  const DelimScanner scanner(delim);
+  const char *begin = input.begin();
+  const char *end = input.end();
+
   // Determine the number of rows
-  const std::size_t num_rows = std::count(std::istreambuf_iterator<char>(input),
-                                          std::istreambuf_iterator<char>(), '\n');
+  const std::size_t num_rows = std::count(begin, end, '\n');
 
   // Determine the number of columns
-  input.seekg(std::ios_base::beg);  // Go to beginning of file
-  std::getline(input, line); // Read in first line
-  const std::size_t num_cols = std::count(line.begin(), line.end(), '\t') + 1;
+  std::size_t num_cols = 1;
+  for (const char *p = scanner.find_field_end(begin, end);
+       p != end && *p != '\n';
+       p = scanner.find_field_end(p + 1, end)) {
+    ++num_cols;
+  }
 
   const std::size_t num_data_rows = num_rows - num_header_rows;
   const std::size_t num_data_cols = num_cols - num_header_cols;
 
-
   // Allocate memory
-  std::vector<std::string> header_rows_row(num_cols);
-  for (std::size_t i = 0; i < num_header_rows; ++i) {
-    header_rows.push_back(header_rows_row);
-  }
-
-  std::vector<std::string> header_cols_row(num_header_cols);
-  for (std::size_t i = 0; i < num_data_rows; ++i) {
-    header_cols.push_back(header_cols_row);
-  }
-
-  std::vector<std::string> data_row(num_data_cols);
-  for (std::size_t i = 0; i < num_data_rows; ++i) {
-    data.push_back(data_row);
-  }
+  header_rows.assign(num_header_rows, std::vector<std::string>(num_cols));
+  header_cols.assign(num_data_rows, std::vector<std::string>(num_header_cols));
+  data.assign(num_data_rows, std::vector<std::string>(num_data_cols));
 
   // Read in data
-  input.seekg(std::ios_base::beg);  // Go to beginning of file
+  const char *token = begin;
   for (std::size_t i = 0; i < num_header_rows; ++i) {
-    std::getline(input, line);
-
-    std::istringstream iss(line);
-    std::string token;
     for (std::size_t j = 0; j < num_cols; ++j) {
-      std::getline(iss, token, '\t');
-      header_rows[i][j] = token;
+      const char *field_end = scanner.find_field_end(token, end);
+      header_rows[i][j].assign(token, field_end);
+      token = scanner.next_field(field_end, end);
     }
+    token = std::min(end, scanner.find_line_end(token, end) + 1);
   }
 
   for (std::size_t i = 0; i < num_data_rows; ++i) {
-    std::getline(input, line);
-
-    std::istringstream iss(line);
-    std::string token;
     for (std::size_t j = 0; j < num_header_cols; ++j) {
-      std::getline(iss, token, '\t');
-      header_cols[i][j] = token;
+      const char *field_end = scanner.find_field_end(token, end);
+      header_cols[i][j].assign(token, field_end);
+      token = scanner.next_field(field_end, end);
     }
     for (std::size_t j = 0; j < num_data_cols; ++j) {
-      std::getline(iss, token, '\t');
-      data[i][j] = token;
+      const char *field_end = scanner.find_field_end(token, end);
+      data[i][j].assign(token, field_end);
+      token = scanner.next_field(field_end, end);
     }
+    token = std::min(end, scanner.find_line_end(token, end) + 1);
   }
-
-  input.close();
 }
 
 //------------------------------------------------------------------------------
@@ -168,7 +158,8 @@ void DataContainer::read(const std::string &file_name,
 //------------------------------------------------------------------------------
 void DataContainer::write(const std::string &file_name,
                           const std::vector<bool> &rows_to_keep,
-                          const std::vector<bool> &cols_to_keep) const
+                          const std::vector<bool> &cols_to_keep,
+                          const std::size_t num_threads) const
 {
   assert(header_rows.size() > 0);
   assert(header_cols.size() > 0);
@@ -183,51 +174,66 @@ void DataContainer::write(const std::string &file_name,
   const std::size_t num_data_rows = get_num_data_rows();
   const std::size_t num_data_cols = get_num_data_cols();
 
-  FILE *output;
-  if ((output = fopen(file_name.c_str(), "w")) == nullptr) {
+  ParallelWriter output(file_name, num_threads);
+  if (!output.is_open()) {
     fprintf(stderr, "ERROR - Could not open file (%s).\n", file_name.c_str());
     exit(EXIT_FAILURE);
   }
- 
-  // Write header rows
-  for (std::size_t i = 0; i < num_header_rows; ++i) {
-    fprintf(output, "%s", header_rows[i][0].c_str());
-
-    for (std::size_t j = 1; j < num_header_cols; ++j) {
-      fprintf(output, "\t%s", header_rows[i][j].c_str());
-    }
 
-    for (std::size_t j = 0; j < num_data_cols; ++j) {
-      if (cols_to_keep[j]) {
-        fprintf(output, "\t%s", header_rows[i][j + num_header_cols].c_str());
-      }
-    }
-    fprintf(output, "\n");
-  }
+  // Blocks of data rows are formatted concurrently, the header rows going at
+  // the start of the first block
+  const std::size_t rows_per_block = 4096;
+  const std::size_t num_blocks = std::max<std::size_t>(1, (num_data_rows + rows_per_block - 1) / rows_per_block);
 
-  // Write header cols and data
-  for (std::size_t i = 0; i < num_data_rows; ++i) {
-    if (rows_to_keep[i]) {
-      fprintf(output, "%s", header_cols[i][0].c_str());
+  output.write_blocks(num_blocks, [&](std::size_t k, BlockBuffer &buffer) {
+    // Write header rows
+    for (std::size_t i = 0; k == 0 && i < num_header_rows; ++i) {
+      buffer.append(header_rows[i][0]);
 
       for (std::size_t j = 1; j < num_header_cols; ++j) {
-        fprintf(output, "\t%s", header_cols[i][j].c_str());
+        buffer.put('\t');
+        buffer.append(header_rows[i][j]);
       }
 
       for (std::size_t j = 0; j < num_data_cols; ++j) {
         if (cols_to_keep[j]) {
-          if (is_data_na(i,j)) {
-            fprintf(output, "\tNA");
-          } else {
-            fprintf(output, "\t%s", data[i][j].c_str());
+          buffer.put('\t');
+          buffer.append(header_rows[i][j + num_header_cols]);
+        }
+      }
+      buffer.put('\n');
+    }
+
+    // Write header cols and data
+    const std::size_t last_row = std::min(num_data_rows, (k + 1) * rows_per_block);
+    for (std::size_t i = k * rows_per_block; i < last_row; ++i) {
+      if (rows_to_keep[i]) {
+        buffer.append(header_cols[i][0]);
+
+        for (std::size_t j = 1; j < num_header_cols; ++j) {
+          buffer.put('\t');
+          buffer.append(header_cols[i][j]);
+        }
+
+        for (std::size_t j = 0; j < num_data_cols; ++j) {
+          if (cols_to_keep[j]) {
+            buffer.put('\t');
+            if (is_data_na(i,j)) {
+              buffer.append("NA", 2);
+            } else {
+              buffer.append(data[i][j]);
+            }
           }
         }
+        buffer.put('\n');
       }
-      fprintf(output, "\n");
     }
-  }
+  });
 
-  fclose(output);
+  if (!output.close()) {
+    fprintf(stderr, "ERROR - Could not write file (%s).\n", file_name.c_str());
+    exit(EXIT_FAILURE);
+  }
 }
 
 
@@ -240,70 +246,29 @@ void DataContainer::write(const std::string &file_name,
 //------------------------------------------------------------------------------
 void DataContainer::write(const std::string &file_name,
                           const std::vector<int> &rows_to_keep,
-                          const std::vector<int> &cols_to_keep) const
+                          const std::vector<int> &cols_to_keep,
+                          const std::size_t num_threads) const
 {
-  assert(header_rows.size() > 0);
-  assert(header_cols.size() > 0);
-  assert(data.size() > 0);
-  assert(data.size() == rows_to_keep.size());
-  assert(data[0].size() == cols_to_keep.size());
-  assert(header_cols.size() == data.size());
-  assert(header_rows[0].size() == header_cols[0].size() + data[0].size());
-  
-  const std::size_t num_header_rows = get_num_header_rows();
-  const std::size_t num_header_cols = get_num_header_cols();
-  const std::size_t num_data_rows = get_num_data_rows();
-  const std::size_t num_data_cols = get_num_data_cols();
-
-  FILE *output;
-  if ((output = fopen(file_name.c_str(), "w")) == nullptr) {
-    fprintf(stderr, "ERROR - Could not open file (%s).\n", file_name.c_str());
-    exit(EXIT_FAILURE);
-  }
- 
-  // Write header rows
-  for (std::size_t i = 0; i < num_header_rows; ++i) {
-    fprintf(output, "%s", header_rows[i][0].c_str());
-
-    for (std::size_t j = 1; j < num_header_cols; ++j) {
-      fprintf(output, "\t%s", header_rows[i][j].c_str());
-    }
+  std::vector<bool> rows_to_keep_bool(rows_to_keep.size(), false);
+  std::vector<bool> cols_to_keep_bool(cols_to_keep.size(), false);
 
-    for (std::size_t j = 0; j < num_data_cols; ++j) {
-      if (cols_to_keep[j]) {
-        fprintf(output, "\t%s", header_rows[i][j + num_header_cols].c_str());
-      }
-    }
-    fprintf(output, "\n");
+  for (std::size_t i = 0; i < rows_to_keep.size(); ++i) {
+    rows_to_keep_bool[i] = (rows_to_keep[i] == 1);
   }
-
-  // Write header cols and data
-  for (std::size_t i = 0; i < num_data_rows; ++i) {
-    if (rows_to_keep[i]) {
-      fprintf(output, "%s", header_cols[i][0].c_str());
-
-      for (std::size_t j = 1; j < num_header_cols; ++j) {
-        fprintf(output, "\t%s", header_cols[i][j].c_str());
-      }
-
-      for (std::size_t j = 0; j < num_data_cols; ++j) {
-        if (cols_to_keep[j]) {
-          if (is_data_na(i,j)) {
-            fprintf(output, "\tNA");
-          } else {
-            fprintf(output, "\t%s", data[i][j].c_str());
-          }
-        }
-      }
-      fprintf(output, "\n");
-    }
+  for (std::size_t j = 0; j < cols_to_keep.size(); ++j) {
+    cols_to_keep_bool[j] = (cols_to_keep[j] == 1);
   }
 
-  fclose(output);
+  write(file_name, rows_to_keep_bool, cols_to_keep_bool, num_threads);
 }
 
-void DataContainer::write_transpose(const std::string &file_name) const {
-assert(header_rows.size() > 0);
+//------------------------------------------------------------------------------
+// Writes out the transpose of the header rows, header columns, and data. Blocks
+// of output lines are formatted concurrently by up to 'num_threads' threads.
+//------------------------------------------------------------------------------
+void DataContainer::write_transpose(const std::string &file_name,
+                                    const std::size_t num_threads) const {
+  assert(header_rows.size() > 0);
   assert(header_cols.size() > 0);
   assert(data.size() > 0);
   assert(header_cols.size() == data.size());
@@ -314,45 +279,57 @@ assert(header_rows.size() > 0);
   const std::size_t num_data_rows = get_num_data_rows();
   const std::size_t num_data_cols = get_num_data_cols();
 
-  FILE *output;
-  if ((output = fopen(file_name.c_str(), "w")) == nullptr) {
+  ParallelWriter output(file_name, num_threads);
+  if (!output.is_open()) {
     fprintf(stderr, "ERROR - Could not open file (%s).\n", file_name.c_str());
     exit(EXIT_FAILURE);
   }
- 
-  // Write header columns
-  for (std::size_t j = 0; j < num_header_cols; ++j) {
 
-    fprintf(output, "%s", header_rows[0][j].c_str());
+  // Every output line holds a whole column, so size the blocks by the number
+  // of fields they hold. The header columns go at the start of the first block.
+  const std::size_t cols_per_block = std::max<std::size_t>(1, (1 << 18) / (num_header_rows + num_data_rows));
+  const std::size_t num_blocks = std::max<std::size_t>(1, (num_data_cols + cols_per_block - 1) / cols_per_block);
 
-    for (std::size_t i = 1; i < num_header_rows; ++i) {
-      fprintf(output, "\t%s", header_rows[i][j].c_str());
-    }
+  output.write_blocks(num_blocks, [&](std::size_t k, BlockBuffer &buffer) {
+    // Write header columns
+    for (std::size_t j = 0; k == 0 && j < num_header_cols; ++j) {
+      buffer.append(header_rows[0][j]);
 
-    for (std::size_t k = 0; k < header_cols.size(); ++k) {
-      fprintf(output, "\t%s", header_cols[k][j].c_str());
-    }
+      for (std::size_t i = 1; i < num_header_rows; ++i) {
+        buffer.put('\t');
+        buffer.append(header_rows[i][j]);
+      }
 
-    fprintf(output, "\n");
-  }
+      for (std::size_t i = 0; i < header_cols.size(); ++i) {
+        buffer.put('\t');
+        buffer.append(header_cols[i][j]);
+      }
+      buffer.put('\n');
+    }
 
-  // // Write header rows and data
-  const std::size_t offset =  header_cols[0].size();
-  for (std::size_t j = 0; j < num_data_cols; ++j) {
+    // Write header rows and data
+    const std::size_t offset = header_cols[0].size();
+    const std::size_t last_col = std::min(num_data_cols, (k + 1) * cols_per_block);
+    for (std::size_t j = k * cols_per_block; j < last_col; ++j) {
+      buffer.append(header_rows[0][j + offset]);
 
-    fprintf(output, "%s", header_rows[0][j + offset].c_str());
+      for (std::size_t i = 1; i < num_header_rows; ++i) {
+        buffer.put('\t');
+        buffer.append(header_rows[i][j + offset]);
+      }
 
-    for (std::size_t i = 1; i < num_header_rows; ++i) {
-      fprintf(output, "\t%s", header_rows[i][j + offset].c_str());
+      for (std::size_t i = 0; i < num_data_rows; ++i) {
+        buffer.put('\t');
+        buffer.append(data[i][j]);
+      }
+      buffer.put('\n');
     }
+  });
 
-    for (std::size_t i = 0; i < num_data_rows; ++i) {
-      fprintf(output, "\t%s", data[i][j].c_str());
-    }
-    fprintf(output, "\n");
+  if (!output.close()) {
+    fprintf(stderr, "ERROR - Could not write file (%s).\n", file_name.c_str());
+    exit(EXIT_FAILURE);
   }
-
-  fclose(output);
 }
 
 //------------------------------------------------------------------------------
@@ -14,21 +14,23 @@ private:
   std::vector<std::size_t> num_valid_rows;
   std::vector<std::size_t> num_valid_cols;
 
-  void read(const std::string &file_name, const std::size_t num_header_rows, const std::size_t num_header_cols );
+  void read(const std::string &file_name, const std::size_t num_header_rows, const std::size_t num_header_cols, const char delim);
   void calc_num_valid();
 
 public:
-  DataContainer(const std::string &file_name, const std::string &_na_symbol, const std::size_t num_header_rows = 1, const std::size_t num_header_cols = 1);
+  DataContainer(const std::string &file_name, const std::string &_na_symbol, const std::size_t num_header_rows = 1, const std::size_t num_header_cols = 1, const char delim = '\t');
   ~DataContainer();
   
   void print_binary(const std::string &filename) const;
   void write(const std::string &file_name,
              const std::vector<bool> &rows_to_keep,
-             const std::vector<bool> &cols_to_keep) const;
+             const std::vector<bool> &cols_to_keep,
+             const std::size_t num_threads = 1) const;
   void write(const std::string &file_name,
              const std::vector<int> &rows_to_keep,
-             const std::vector<int> &cols_to_keep) const;
-  void write_transpose(const std::string &file_name) const;
+             const std::vector<int> &cols_to_keep,
+             const std::size_t num_threads = 1) const;
+  void write_transpose(const std::string &file_name, const std::size_t num_threads = 1) const;
   
   std::size_t get_num_header_rows() const;
   std::size_t get_num_header_cols() const;
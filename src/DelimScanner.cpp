@@ -0,0 +1,138 @@
+#include "DelimScanner.h"
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define MRCLEAN_X86
+#endif
+
+//------------------------------------------------------------------------------
+// Scalar scan used for short tails and on non-x86 targets.
+//------------------------------------------------------------------------------
+static const char *find_scalar(const char *begin, const char *end, const char delim) {
+  for (; begin < end; ++begin) {
+    if (*begin == delim || *begin == '\n') {
+      return begin;
+    }
+  }
+  return end;
+}
+
+#ifdef MRCLEAN_X86
+//------------------------------------------------------------------------------
+// Compares 16 bytes at a time against the delimiter and newline (SSE2).
+//------------------------------------------------------------------------------
+static const char *find_sse2(const char *begin, const char *end, const char delim) {
+  const __m128i d = _mm_set1_epi8(delim);
+  const __m128i nl = _mm_set1_epi8('\n');
+
+  while (end - begin >= 16) {
+    const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(begin));
+    const int mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(block, d),
+                                                    _mm_cmpeq_epi8(block, nl)));
+    if (mask != 0) {
+      return begin + __builtin_ctz(mask);
+    }
+    begin += 16;
+  }
+  return find_scalar(begin, end, delim);
+}
+
+//------------------------------------------------------------------------------
+// Compares 32 bytes at a time against the delimiter and newline (AVX2).
+//------------------------------------------------------------------------------
+__attribute__((target("avx2")))
+static const char *find_avx2(const char *begin, const char *end, const char delim) {
+  const __m256i d = _mm256_set1_epi8(delim);
+  const __m256i nl = _mm256_set1_epi8('\n');
+
+  while (end - begin >= 32) {
+    const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(begin));
+    const unsigned mask = _mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(block, d),
+                                                               _mm256_cmpeq_epi8(block, nl)));
+    if (mask != 0) {
+      return begin + __builtin_ctz(mask);
+    }
+    begin += 32;
+  }
+  return find_sse2(begin, end, delim);
+}
+#endif
+
+//------------------------------------------------------------------------------
+// Constructor. Selects the widest vector implementation the CPU supports.
+//------------------------------------------------------------------------------
+DelimScanner::DelimScanner(const char _delim) : delim(_delim),
+                                                find_impl(find_scalar) {
+#ifdef MRCLEAN_X86
+  find_impl = __builtin_cpu_supports("avx2") ? find_avx2 : find_sse2;
+#endif
+}
+
+//------------------------------------------------------------------------------
+// Destructor.
+//------------------------------------------------------------------------------
+DelimScanner::~DelimScanner() {}
+
+//------------------------------------------------------------------------------
+// Returns the field delimiter.
+//------------------------------------------------------------------------------
+char DelimScanner::get_delim() const {
+  return delim;
+}
+
+//------------------------------------------------------------------------------
+// Returns a pointer to the first delimiter or newline in [begin, end), or
+// 'end' if there is none.
+//------------------------------------------------------------------------------
+const char *DelimScanner::find_field_end(const char *begin, const char *end) const {
+  return find_impl(begin, end, delim);
+}
+
+//------------------------------------------------------------------------------
+// Returns a pointer to the first newline in [begin, end), or 'end' if there is
+// none.
+//------------------------------------------------------------------------------
+const char *DelimScanner::find_line_end(const char *begin, const char *end) const {
+  const char *eol = static_cast<const char *>(memchr(begin, '\n', end - begin));
+  return (eol == nullptr) ? end : eol;
+}
+
+//------------------------------------------------------------------------------
+// Given the end of a field (as returned by find_field_end), returns the start
+// of the next field on the same line. When the field was the last one on its
+// line, the line end is returned so later fields of that line are empty.
+//------------------------------------------------------------------------------
+const char *DelimScanner::next_field(const char *field_end, const char *end) const {
+  return (field_end < end && *field_end == delim) ? field_end + 1 : field_end;
+}
+
+//------------------------------------------------------------------------------
+// Removes leading and trailing spaces from the token [begin, end). A token
+// made up of only spaces is left unchanged.
+//------------------------------------------------------------------------------
+void DelimScanner::trim(const char *&begin, const char *&end) {
+  const char *first = begin;
+  while (first < end && *first == ' ') {
+    ++first;
+  }
+  if (first == end) {
+    return;
+  }
+
+  const char *last = end;
+  while (*(last - 1) == ' ') {
+    --last;
+  }
+  begin = first;
+  end = last;
+}
+
+//------------------------------------------------------------------------------
+// Returns true if the trimmed token [begin, end) matches 'symbol'.
+//------------------------------------------------------------------------------
+bool DelimScanner::is_token(const char *begin, const char *end, const std::string &symbol) {
+  trim(begin, end);
+  const std::size_t len = end - begin;
+  return len == symbol.size() && memcmp(begin, symbol.data(), len) == 0;
+}
@@ -0,0 +1,25 @@
+#ifndef DELIM_SCANNER_H
+#define DELIM_SCANNER_H
+
+#include <string>
+
+class DelimScanner {
+private:
+  const char delim;
+  const char *(*find_impl)(const char *begin, const char *end, const char delim);
+
+public:
+  DelimScanner(const char _delim = '\t');
+  ~DelimScanner();
+
+  char get_delim() const;
+
+  const char *find_field_end(const char *begin, const char *end) const;
+  const char *find_line_end(const char *begin, const char *end) const;
+  const char *next_field(const char *field_end, const char *end) const;
+
+  static void trim(const char *&begin, const char *&end);
+  static bool is_token(const char *begin, const char *end, const std::string &symbol);
+};
+
+#endif
@@ -0,0 +1,123 @@
+#include "FileWriter.h"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+  // Ranges smaller than this are copied through the buffer
+  const std::size_t min_copy_range = 1 << 16;
+}
+
+//------------------------------------------------------------------------------
+// Constructor. Creates or truncates 'file_name'. On failure is_open() returns
+// false.
+//------------------------------------------------------------------------------
+FileWriter::FileWriter(const std::string &file_name,
+                       const std::size_t buffer_size) : fd(-1),
+                                                        failed(false),
+                                                        buffer(buffer_size > 0 ? buffer_size : 1),
+                                                        used(0) {
+  fd = open(file_name.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+}
+
+//------------------------------------------------------------------------------
+// Destructor. Flushes and closes the file if close() was not called.
+//------------------------------------------------------------------------------
+FileWriter::~FileWriter() {
+  close();
+}
+
+//------------------------------------------------------------------------------
+// Returns true if the file was opened.
+//------------------------------------------------------------------------------
+bool FileWriter::is_open() const {
+  return fd >= 0;
+}
+
+//------------------------------------------------------------------------------
+// Writes all of [bytes, bytes + size) to the file.
+//------------------------------------------------------------------------------
+bool FileWriter::write_all(const char *bytes, std::size_t size) {
+  while (size > 0) {
+    const ssize_t n = write(fd, bytes, size);
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    bytes += n;
+    size -= n;
+  }
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Appends bytes to the file. Writes larger than the buffer bypass it.
+//------------------------------------------------------------------------------
+void FileWriter::append(const char *bytes, const std::size_t size) {
+  if (used + size <= buffer.size()) {
+    memcpy(buffer.data() + used, bytes, size);
+    used += size;
+    return;
+  }
+
+  flush();
+  if (size >= buffer.size()) {
+    failed = failed || !write_all(bytes, size);
+  } else {
+    memcpy(buffer.data(), bytes, size);
+    used = size;
+  }
+}
+
+//------------------------------------------------------------------------------
+// Appends 'size' bytes of the file open as 'in_fd', starting at 'offset'.
+// 'mapped' points at the same bytes in memory and is used when the range is
+// small or the kernel cannot copy between the two files.
+//------------------------------------------------------------------------------
+void FileWriter::copy_range(const int in_fd, off_t offset, std::size_t size, const char *mapped) {
+  if (size < min_copy_range || in_fd < 0) {
+    append(mapped, size);
+    return;
+  }
+
+  flush();
+  while (size > 0) {
+    const ssize_t n = copy_file_range(in_fd, &offset, fd, nullptr, size, 0);
+    if (n <= 0) {
+      if (n < 0 && errno == EINTR) {
+        continue;
+      }
+      // Not supported for these files; write the rest from memory
+      failed = failed || !write_all(mapped, size);
+      return;
+    }
+    mapped += n;
+    size -= n;
+  }
+}
+
+//------------------------------------------------------------------------------
+// Writes the buffered bytes to the file.
+//------------------------------------------------------------------------------
+void FileWriter::flush() {
+  if (used > 0 && fd >= 0) {
+    failed = failed || !write_all(buffer.data(), used);
+  }
+  used = 0;
+}
+
+//------------------------------------------------------------------------------
+// Flushes and closes the file. Returns false if any write failed.
+//------------------------------------------------------------------------------
+bool FileWriter::close() {
+  if (fd < 0) {
+    return false;
+  }
+  flush();
+  const bool closed = ::close(fd) == 0;
+  fd = -1;
+  return closed && !failed;
+}
@@ -0,0 +1,44 @@
+#ifndef FILE_WRITER_H
+#define FILE_WRITER_H
+
+#include <cstddef>
+#include <string>
+#include <sys/types.h>
+#include <vector>
+
+//------------------------------------------------------------------------------
+// Output file written through a large buffer with write(2). Byte ranges of
+// another file can be copied in with copy_file_range(2), which lets the kernel
+// move the data without it passing through the buffer.
+//------------------------------------------------------------------------------
+class FileWriter {
+private:
+  int fd;
+  bool failed;
+  std::vector<char> buffer;
+  std::size_t used;
+
+  bool write_all(const char *bytes, std::size_t size);
+
+public:
+  FileWriter(const std::string &file_name, const std::size_t buffer_size = 1 << 20);
+  ~FileWriter();
+
+  FileWriter(const FileWriter &) = delete;
+  FileWriter &operator=(const FileWriter &) = delete;
+
+  bool is_open() const;
+
+  void put(const char c) {
+    if (used == buffer.size()) {
+      flush();
+    }
+    buffer[used++] = c;
+  }
+  void append(const char *bytes, const std::size_t size);
+  void copy_range(const int in_fd, off_t offset, std::size_t size, const char *mapped);
+  void flush();
+  bool close();
+};
+
+#endif
@@ -1,7 +1,15 @@
 #include "GreedySolver.h"
 #include <assert.h>
 #include <algorithm>
+#include <cmath>
+#include "AllocCounter.h"
 #include "MrCleanUtils.h"
+#include "PopcountKernels.h"
+
+namespace {
+  // Smallest amount of work, in 64-bit words, handed to one thread
+  const std::size_t min_words_per_chunk = 1 << 14;
+}
 
 //------------------------------------------------------------------------------
 // Constructor.
@@ -9,20 +17,57 @@
 GreedySolver::GreedySolver(const BinContainer &_data,
                            const double _max_perc_miss,
                            const std::size_t _row_lb,
-                           const std::size_t _col_lb) : data(&_data),
-                                                          num_rows(data->get_num_data_rows()),
-                                                          num_cols(data->get_num_data_cols()),
-                                                          max_perc_miss(_max_perc_miss),
-                                                          row_lb(_row_lb),
-                                                          col_lb(_col_lb),
-                                                          alphas(num_rows),
-                                                          betas(num_cols),
-                                                          keep_row(num_rows, true),
-                                                          keep_col(num_cols, true),
-                                                          num_rows_kept(num_rows),
-                                                          num_cols_kept(num_cols) {
+                           const std::size_t _col_lb,
+                           ThreadPool *_pool) : data(&_data),
+                                                pool(_pool),
+                                                num_rows(data->get_num_data_rows()),
+                                                num_cols(data->get_num_data_cols()),
+                                                max_perc_miss(_max_perc_miss),
+                                                row_lb(_row_lb),
+                                                col_lb(_col_lb),
+                                                alphas(num_rows),
+                                                betas(num_cols),
+                                                keep_row(mr_clean_utils::make_full_mask(num_rows)),
+                                                keep_col(mr_clean_utils::make_full_mask(num_cols)),
+                                                removed_rows(keep_row.size(), 0),
+                                                removed_cols(keep_col.size(), 0),
+                                                row_delta(pool ? num_rows : 0),
+                                                col_delta(pool ? num_cols : 0),
+                                                chunk_offsets(pool ? pool->get_num_threads() + 1 : 2),
+                                                num_rows_kept(num_rows),
+                                                num_cols_kept(num_cols),
+                                                num_valid_kept(data->get_num_valid_data()),
+                                                num_solve_allocations(0),
+                                                tracing(false),
+                                                incumbent(nullptr),
+                                                abandoned(false) {
+  // Scratch space used by solve(), sized once so the loop does not allocate
+  const std::size_t max_dim = std::max(num_rows, num_cols);
+  idx_to_remove.reserve(max_dim);
+  missing.reserve(max_dim);
+  selected.reserve(max_dim);
+
   calc_alphas();
   calc_betas();
+
+  row_queue = SelectionQueue(alphas, num_cols);
+  col_queue = SelectionQueue(betas, num_rows);
+  update_thresholds();
+}
+
+//------------------------------------------------------------------------------
+// Constructor. Continues from the state of 'start', solved for a looser (or
+// equal) max_perc_miss: rows and columns removed by 'start' stay removed and
+// solve() only removes what the tighter threshold requires.
+//------------------------------------------------------------------------------
+GreedySolver::GreedySolver(const GreedySolver &start,
+                           const double _max_perc_miss) : GreedySolver(start) {
+  if (_max_perc_miss > start.max_perc_miss) {
+    fprintf(stderr, "ERROR - Can only continue to a tighter max_perc_miss (%lf vs. %lf).\n", _max_perc_miss, start.max_perc_miss);
+    exit(EXIT_FAILURE);
+  }
+  max_perc_miss = _max_perc_miss;
+  update_thresholds();
 }
 
 //------------------------------------------------------------------------------
@@ -31,42 +76,76 @@ GreedySolver::GreedySolver(const BinContainer &_data,
 GreedySolver::~GreedySolver() {}
 
 //------------------------------------------------------------------------------
-// Run greedy solver.
+// Makes solve() log each removal step in the trace. Must be called before the
+// first solve(); a solver continued from this one keeps logging to a copy of
+// the trace, so its trace still starts from the full matrix.
+//------------------------------------------------------------------------------
+void GreedySolver::record_trace() {
+  assert(num_rows_kept == num_rows && num_cols_kept == num_cols);
+  tracing = true;
+  trace = RemovalTrace(num_rows, num_cols, num_valid_kept);
+}
+
+//------------------------------------------------------------------------------
+// Breaks ties between rows, and between columns, in an order drawn from 'seed'
+// instead of by the lowest index: the worst row or column among those with
+// the same number of valid elements, and the order of the rows or columns
+// with the same number of valid elements picked for removal. Must be called
+// before the first solve().
+//------------------------------------------------------------------------------
+void GreedySolver::randomize_ties(const uint64_t seed) {
+  assert(num_rows_kept == num_rows && num_cols_kept == num_cols);
+  std::mt19937_64 rng(seed);
+  row_rank = mr_clean_utils::make_random_ranks(num_rows, rng());
+  col_rank = mr_clean_utils::make_random_ranks(num_cols, rng());
+
+  row_queue = SelectionQueue(alphas, num_cols, row_rank);
+  col_queue = SelectionQueue(betas, num_rows, col_rank);
+  update_thresholds();
+}
+
+//------------------------------------------------------------------------------
+// Makes solve() give up once the solution keeps fewer valid elements than
+// '_incumbent', shared with other solvers. Removing rows and columns never
+// adds valid elements, so the final solution could not have been better.
+//------------------------------------------------------------------------------
+void GreedySolver::set_incumbent(const std::atomic<std::size_t> *_incumbent) {
+  incumbent = _incumbent;
+}
+
+//------------------------------------------------------------------------------
+// Run greedy solver. A solve that reaches the dimension limit, or the limit of
+// one dimension while only the other one is over the maximum, is given up so
+// that the caller can fall back on another solver's solution.
 //------------------------------------------------------------------------------
 void GreedySolver::solve() {
   // Loop until matrix is cleaned or dimension limit is reached
+  const std::size_t num_allocations = alloc_counter::get_thread_count();
+  abandoned = false;
+
   while (!matrix_cleaned()) {
     bool idx_is_row = true;
-    std::vector<std::size_t> idx_to_remove;
+    idx_to_remove.clear();
 
     // Check if both dimension limits are reached
     if (get_num_rows_kept() == row_lb && get_num_cols_kept() == col_lb) {
-      fprintf(stderr, "ERROR - Matrix is at dimension limit (%lu x %lu), but fails percent missing requirement\n", row_lb, col_lb);
-      exit(EXIT_FAILURE);
+      abandoned = true;
+      break;
     } else if (get_num_rows_kept() == row_lb) { // Row limit reached
-      // Find row with most missing data
-      std::size_t idx = num_rows;
-      double worst_perc_miss = 0.0;
-      for (std::size_t i = 0; i < num_rows; ++i) {
-        if (keep_row[i] &&
-            get_perc_miss_row(i) > max_perc_miss &&
-            get_perc_miss_row(i) > worst_perc_miss) {
-          worst_perc_miss = get_perc_miss_row(i);
-          idx = i;
-        }
-      }
-
-      if (idx == num_rows) {
-        fprintf(stderr, "ERROR - Could not find row with missing data over threshold.\n");
-        exit(EXIT_FAILURE);
+      // Find row with most missing data. All kept rows share the same
+      // denominator, so this is the row with the fewest valid elements.
+      if (row_queue.get_num_violators() == 0) {
+        abandoned = true;
+        break;
       }
+      std::size_t idx = row_queue.top();
 
       // Calculate the number of columns that need to be removed so that the percent of missing data
       // in the row is <= the maximum amount allowed
       std::size_t k = calc_num_cols_to_remove(idx);
 
       // Get all columns with missing data for the desired row
-      auto colsWithMissingData = get_missing_cols(idx);
+      const auto &colsWithMissingData = get_missing_cols(idx);
 
       // Verify that there are enough columns to remove
       if (k > colsWithMissingData.size()) {
@@ -74,12 +153,8 @@ void GreedySolver::solve() {
         exit(EXIT_FAILURE);
       }
 
-      // Sort the columns with missing data based on the number of valid elements in each column
-      std::vector<std::pair<std::size_t, std::size_t>> sortedCols;
-      for (auto j : colsWithMissingData) {
-        sortedCols.push_back(std::make_pair(j, betas[j]));
-      }
-      std::sort(sortedCols.begin(), sortedCols.end(), mr_clean_utils::SortPairBySecondItemDecreasing());
+      // Select the k columns with missing data that have the most valid elements, in decreasing order
+      const auto &sortedCols = select_most_valid(colsWithMissingData, betas, col_rank, k);
 
       // Add columns to 'idx_to_remove' and set flag indicating columns
       for (std::size_t j = 0; j < k; j++) {
@@ -89,29 +164,18 @@ void GreedySolver::solve() {
 
     } else if (get_num_cols_kept() == col_lb) { // Column limit reached
       // Find columns with most missing data
-      std::size_t idx = num_cols;
-      double worst_perc_miss = 0.0;
-      for (std::size_t j = 0; j < num_cols; ++j) {
-        if (keep_col[j] &&
-            get_perc_miss_col(j) > max_perc_miss &&
-            get_perc_miss_col(j) > worst_perc_miss) {
-          worst_perc_miss = get_perc_miss_col(j);
-          idx = j;
-        }
-      }
-
-      // Check that valid column was found
-      if (idx == num_cols) {
-        fprintf(stderr, "ERROR - Could not find column with missing data over threshold.\n");
-        exit(EXIT_FAILURE);
+      if (col_queue.get_num_violators() == 0) {
+        abandoned = true;
+        break;
       }
+      std::size_t idx = col_queue.top();
 
       // Calculate the number of rows that need to be removed so that the percent of missing data
       // in the column is <= the maximum amount allowed
       std::size_t k = calc_num_rows_to_remove(idx);
 
       // Get all rows with missing data for the desired column
-      auto rowsWithMissingData = get_missing_rows(idx);
+      const auto &rowsWithMissingData = get_missing_rows(idx);
 
       // Verify that there are enough rows to remove
       if (k > rowsWithMissingData.size()) {
@@ -119,12 +183,8 @@ void GreedySolver::solve() {
         exit(EXIT_FAILURE);
       }
 
-      // Sort the rows with missing data based on the number of valid elements in each row
-      std::vector<std::pair<std::size_t, std::size_t>> sortedRows;
-      for (auto i : rowsWithMissingData) {
-        sortedRows.push_back(std::make_pair(i, alphas[i]));
-      }
-      std::sort(sortedRows.begin(), sortedRows.end(), mr_clean_utils::SortPairBySecondItemDecreasing());
+      // Select the k rows with missing data that have the most valid elements, in decreasing order
+      const auto &sortedRows = select_most_valid(rowsWithMissingData, alphas, row_rank, k);
 
       // Add rows to 'idx_to_remove' and set flag indicating rows
       for (std::size_t i = 0; i < k; i++) {
@@ -133,42 +193,27 @@ void GreedySolver::solve() {
       idx_is_row = true;
 
     } else { // No limit reached
-      // Reset values
-      bool found_row_col_to_remove = false;
-      bool row = false;
-      std::size_t idx = 0;
-      double worse_perc_miss = 0.0;
-
-      // Loop through all rows checking for a row that is 1) valid, 2) whose percentange of missing data is >
-      // the maximum allowed, 3) has the highest percent of missing data. If a row is found save information
-      // for future use.
-      for (std::size_t i = 0; i < num_rows; ++i) {
-        if (keep_row[i] &&
-            get_perc_miss_row(i) > max_perc_miss &&
-            get_perc_miss_row(i) > worse_perc_miss) {
-          worse_perc_miss = get_perc_miss_row(i);
-          row = true;
-          idx = i;
-          found_row_col_to_remove = true;
-        }
-      }
-   
-      // Loop through all columns checking for a columns that is 1) valid, 2) whose percentange of missing data
-      // is > the maximum allowed, 3) has the highest percent of missing data. If a column is found save
-      // information for future use.
-      for (std::size_t j = 0; j < num_cols; ++j) {
-        if (keep_col[j] &&
-            get_perc_miss_col(j) > max_perc_miss &&
-            get_perc_miss_col(j) > worse_perc_miss) {
-          worse_perc_miss = get_perc_miss_col(j);
+      // Find the row that is 1) valid, 2) whose percentange of missing data is > the maximum allowed, 3) has
+      // the highest percent of missing data. Ties go to the lowest index.
+      const bool found_row = row_queue.get_num_violators() > 0;
+      bool row = found_row;
+      std::size_t idx = found_row ? row_queue.top() : 0;
+
+      // Find the column meeting the same 3 criteria. It is selected only if its percent of missing data is
+      // strictly higher than that of the row, compared exactly by cross-multiplying the counts.
+      const bool found_col = col_queue.get_num_violators() > 0;
+      if (found_col) {
+        const std::size_t j = col_queue.top();
+        if (!found_row ||
+            static_cast<uint64_t>(get_num_missing_col(j)) * num_cols_kept >
+            static_cast<uint64_t>(get_num_missing_row(idx)) * num_rows_kept) {
           row = false;
           idx = j;
-          found_row_col_to_remove = true;
         }
       }
 
       // If no row or column was found above that matches the 3 criteria report error
-      if (!found_row_col_to_remove) {
+      if (!found_row && !found_col) {
         fprintf(stderr, "ERROR - Could not find row or column over max_perc_miss limit.\n");
         exit(EXIT_FAILURE);
       }
@@ -183,7 +228,7 @@ void GreedySolver::solve() {
         std::size_t k = calc_num_cols_to_remove(idx);
 
         // Get all columns with missing data for the desired row
-        auto colsWithMissingData = get_missing_cols(idx);
+        const auto &colsWithMissingData = get_missing_cols(idx);
 
         // Verify that there are enough columns to remove
         if (k > colsWithMissingData.size()) {
@@ -191,12 +236,8 @@ void GreedySolver::solve() {
           exit(EXIT_FAILURE);
         }
 
-        // Sort the columns with missing data based on the number of valid elements in each column
-        std::vector<std::pair<std::size_t, std::size_t>> sortedCols;
-        for (auto j : colsWithMissingData) {
-          sortedCols.push_back(std::make_pair(j, betas[j]));
-        }
-        std::sort(sortedCols.begin(), sortedCols.end(), mr_clean_utils::SortPairBySecondItemDecreasing());
+        // Select the k columns with missing data that have the most valid elements, in decreasing order
+        const auto &sortedCols = select_most_valid(colsWithMissingData, betas, col_rank, k);
       
         // Calculate the number of valid elements that would be removed if the 'k' columns with the least amount of valid elements
         // are removed.
@@ -225,7 +266,7 @@ void GreedySolver::solve() {
         std::size_t k = calc_num_rows_to_remove(idx);
 
         // Get all rows with missing data for the desired row
-        auto rowsWithMissingData = get_missing_rows(idx);
+        const auto &rowsWithMissingData = get_missing_rows(idx);
 
         // Verify that there are enough rows to remove
         if (k > rowsWithMissingData.size()) {
@@ -233,12 +274,8 @@ void GreedySolver::solve() {
           exit(EXIT_FAILURE);
         }
 
-        // Sort the rows with missing data based on the number of valid elements in each row
-        std::vector<std::pair<std::size_t, std::size_t>> sortedRows;
-        for (auto i : rowsWithMissingData) {
-          sortedRows.push_back(std::make_pair(i, alphas[i]));
-        }
-        std::sort(sortedRows.begin(), sortedRows.end(), mr_clean_utils::SortPairBySecondItemDecreasing());
+        // Select the k rows with missing data that have the most valid elements, in decreasing order
+        const auto &sortedRows = select_most_valid(rowsWithMissingData, alphas, row_rank, k);
       
         // Calculate the number of valid elements that would be removed if the 'k' rows with the least amount of valid elements
         // are removed.
@@ -269,81 +306,265 @@ void GreedySolver::solve() {
 
     // Determine if rows or columns are selected for removal
     if (idx_is_row) { // Remove rows
-      // Loop through all rows to remove
-      for (auto idx : idx_to_remove) {
-        // Check that row limit has not been reached
-        if (get_num_rows_kept() > row_lb) {
-          remove_row(idx);
-          update_cols(idx);
-        }
-      }
+      remove_rows(idx_to_remove);
     } else { // Remove columns
-      // Loop through all columns to remove
-      for (auto idx : idx_to_remove) {
-        // Check that columns limit has not been reached
-        if (get_num_cols_kept() > col_lb) {
-          remove_col(idx);
-          update_rows(idx);
-        }
-      }    
+      remove_cols(idx_to_remove);
+    }
+
+    if (tracing) {
+      trace.end_step(idx_is_row, num_rows_kept, num_cols_kept, num_valid_kept);
+    }
+
+    if (incumbent != nullptr && num_valid_kept < incumbent->load(std::memory_order_relaxed)) {
+      abandoned = true;
+      break;
     }
   }
+
+  num_solve_allocations = alloc_counter::get_thread_count() - num_allocations;
 }
 
 //------------------------------------------------------------------------------
 // Calculates the number of valid elements in each row.
 //------------------------------------------------------------------------------
 void GreedySolver::calc_alphas() {
-  for (std::size_t i = 0; i < num_rows; ++i) {
-    alphas[i] = 0;
+  const std::size_t min_rows = std::max<std::size_t>(1, min_words_per_chunk / std::max<std::size_t>(1, keep_col.size()));
 
-    for (std::size_t j = 0; j < num_cols; ++j) {
-      if (keep_col[j] && !data->is_data_na(i,j)) {
-        ++alphas[i];
-      }
+  run_chunks(num_rows, min_rows, [&](std::size_t, std::size_t begin, std::size_t end) {
+    for (std::size_t i = begin; i < end; ++i) {
+      alphas[i] = popcount_kernels::count_and(data->get_row_words(i), keep_col.data(), keep_col.size());
     }
-  }
+  });
 }
 
 //------------------------------------------------------------------------------
-// Calculates the number of valid elements in each column.
+// Calculates the number of valid elements in each column. The serial path uses
+// the bitsliced column counter; with a thread pool each thread counts a range
+// of columns from the column-major copy instead.
 //------------------------------------------------------------------------------
 void GreedySolver::calc_betas() {
-  for (std::size_t j = 0; j < num_cols; ++j) {
-    betas[j] = 0;
+  if (pool == nullptr || pool->get_num_threads() == 1) {
+    data->count_valid_in_cols(keep_row, betas);
+    return;
+  }
 
-    for (std::size_t i = 0; i < num_rows; ++i) {
-      if (keep_row[i] && !data->is_data_na(i,j)) {
-        ++betas[j];
-      }
+  const std::size_t min_cols = std::max<std::size_t>(1, min_words_per_chunk / std::max<std::size_t>(1, keep_row.size()));
+
+  run_chunks(num_cols, min_cols, [&](std::size_t, std::size_t begin, std::size_t end) {
+    for (std::size_t j = begin; j < end; ++j) {
+      betas[j] = popcount_kernels::count_and(data->get_col_words(j), keep_row.data(), keep_row.size());
     }
+  });
+}
+
+//------------------------------------------------------------------------------
+// Returns the number of chunks run_chunks() splits 'n' items into.
+//------------------------------------------------------------------------------
+std::size_t GreedySolver::get_num_chunks(const std::size_t n, const std::size_t min_chunk) const {
+  if (pool != nullptr) {
+    return pool->get_num_chunks(n, min_chunk);
   }
+  return n > 0 ? 1 : 0;
 }
 
 //------------------------------------------------------------------------------
 // Remove a row from the solution by updating the boolean vector and decreasing
-// the number of rows kept counter.
+// the number of rows kept and valid elements kept counters.
 //------------------------------------------------------------------------------
 void GreedySolver::remove_row(const std::size_t idx) {
   assert(idx < num_rows);
 
-  if (keep_row[idx]) {
+  if (is_row_kept(idx)) {
     --num_rows_kept;
+    num_valid_kept -= alphas[idx];
+    if (tracing) {
+      trace.add_removed(idx);
+    }
+    row_queue.remove(idx);
+    update_thresholds();
   }
-  keep_row[idx] = false;
+  mr_clean_utils::clear_bit(keep_row.data(), idx);
 }
 
 //------------------------------------------------------------------------------
 // Remove a column from the solution by updating the boolean vector and
-// decreasing the number of rows kept counter.
+// decreasing the number of columns kept and valid elements kept counters.
 //------------------------------------------------------------------------------
 void GreedySolver::remove_col(const std::size_t idx) {
   assert(idx < num_cols);
 
-  if (keep_col[idx]) {
+  if (is_col_kept(idx)) {
     --num_cols_kept;
+    num_valid_kept -= betas[idx];
+    if (tracing) {
+      trace.add_removed(idx);
+    }
+    col_queue.remove(idx);
+    update_thresholds();
+  }
+  mr_clean_utils::clear_bit(keep_col.data(), idx);
+}
+
+//------------------------------------------------------------------------------
+// Removes the rows in 'idx_to_remove', in order, until the row limit is
+// reached, then updates the column counts for all of them at once. When the
+// batch is large, each kept column's count is lowered by
+// popcount(column AND removed-row mask) in a single pass over the columns;
+// a small batch is cheaper to apply one removed row at a time.
+//------------------------------------------------------------------------------
+void GreedySolver::remove_rows(const std::vector<std::size_t> &idx_to_remove) {
+  std::size_t num_removed = 0;
+  std::size_t min_word = removed_rows.size();
+  std::size_t max_word = 0;
+
+  for (auto idx : idx_to_remove) {
+    // Check that row limit has not been reached
+    if (get_num_rows_kept() <= row_lb) {
+      break;
+    }
+    remove_row(idx);
+    mr_clean_utils::set_bit(removed_rows.data(), idx);
+    min_word = std::min(min_word, idx >> 6);
+    max_word = std::max(max_word, idx >> 6);
+    ++num_removed;
+  }
+
+  if (num_removed == 0) {
+    return;
+  }
+
+  const std::size_t span = max_word - min_word + 1;
+  if (num_removed * keep_col.size() <= num_cols_kept * span) {
+    for (std::size_t k = 0; k < num_removed; ++k) {
+      update_cols(idx_to_remove[k]);
+    }
+  } else if (pool == nullptr) {
+    for (std::size_t w = 0; w < keep_col.size(); ++w) {
+      uint64_t bits = keep_col[w];
+      while (bits) {
+        const std::size_t j = (w << 6) + __builtin_ctzll(bits);
+        const std::size_t delta = popcount_kernels::count_and(data->get_col_words(j) + min_word,
+                                                              removed_rows.data() + min_word,
+                                                              span);
+        if (delta > 0) {
+          betas[j] -= delta;
+          col_queue.decrease_key(j, delta);
+        }
+        bits &= bits - 1;
+      }
+    }
+  } else {
+    // Count in parallel, then apply the counts to the queue in column order
+    const std::size_t min_mask_words = std::max<std::size_t>(1, min_words_per_chunk / (64 * span));
+    run_chunks(keep_col.size(), min_mask_words, [&](std::size_t, std::size_t begin, std::size_t end) {
+      for (std::size_t w = begin; w < end; ++w) {
+        uint64_t bits = keep_col[w];
+        while (bits) {
+          const std::size_t j = (w << 6) + __builtin_ctzll(bits);
+          col_delta[j] = popcount_kernels::count_and(data->get_col_words(j) + min_word,
+                                                     removed_rows.data() + min_word,
+                                                     span);
+          bits &= bits - 1;
+        }
+      }
+    });
+    apply_deltas(keep_col, col_delta, betas, col_queue);
+  }
+
+  for (std::size_t w = min_word; w <= max_word; ++w) {
+    removed_rows[w] = 0;
+  }
+}
+
+//------------------------------------------------------------------------------
+// Removes the columns in 'idx_to_remove', in order, until the column limit is
+// reached, then updates the row counts for all of them at once. Mirrors
+// remove_rows().
+//------------------------------------------------------------------------------
+void GreedySolver::remove_cols(const std::vector<std::size_t> &idx_to_remove) {
+  std::size_t num_removed = 0;
+  std::size_t min_word = removed_cols.size();
+  std::size_t max_word = 0;
+
+  for (auto idx : idx_to_remove) {
+    // Check that columns limit has not been reached
+    if (get_num_cols_kept() <= col_lb) {
+      break;
+    }
+    remove_col(idx);
+    mr_clean_utils::set_bit(removed_cols.data(), idx);
+    min_word = std::min(min_word, idx >> 6);
+    max_word = std::max(max_word, idx >> 6);
+    ++num_removed;
+  }
+
+  if (num_removed == 0) {
+    return;
+  }
+
+  const std::size_t span = max_word - min_word + 1;
+  if (num_removed * keep_row.size() <= num_rows_kept * span) {
+    for (std::size_t k = 0; k < num_removed; ++k) {
+      update_rows(idx_to_remove[k]);
+    }
+  } else if (pool == nullptr) {
+    for (std::size_t w = 0; w < keep_row.size(); ++w) {
+      uint64_t bits = keep_row[w];
+      while (bits) {
+        const std::size_t i = (w << 6) + __builtin_ctzll(bits);
+        const std::size_t delta = popcount_kernels::count_and(data->get_row_words(i) + min_word,
+                                                              removed_cols.data() + min_word,
+                                                              span);
+        if (delta > 0) {
+          alphas[i] -= delta;
+          row_queue.decrease_key(i, delta);
+        }
+        bits &= bits - 1;
+      }
+    }
+  } else {
+    // Count in parallel, then apply the counts to the queue in row order
+    const std::size_t min_mask_words = std::max<std::size_t>(1, min_words_per_chunk / (64 * span));
+    run_chunks(keep_row.size(), min_mask_words, [&](std::size_t, std::size_t begin, std::size_t end) {
+      for (std::size_t w = begin; w < end; ++w) {
+        uint64_t bits = keep_row[w];
+        while (bits) {
+          const std::size_t i = (w << 6) + __builtin_ctzll(bits);
+          row_delta[i] = popcount_kernels::count_and(data->get_row_words(i) + min_word,
+                                                     removed_cols.data() + min_word,
+                                                     span);
+          bits &= bits - 1;
+        }
+      }
+    });
+    apply_deltas(keep_row, row_delta, alphas, row_queue);
+  }
+
+  for (std::size_t w = min_word; w <= max_word; ++w) {
+    removed_cols[w] = 0;
+  }
+}
+
+//------------------------------------------------------------------------------
+// Subtracts the per-item counts in 'delta' from the kept items' counts and
+// their queue keys. The queue is updated serially, one item at a time in index
+// order.
+//------------------------------------------------------------------------------
+void GreedySolver::apply_deltas(const std::vector<uint64_t> &keep,
+                                const std::vector<std::size_t> &delta,
+                                std::vector<std::size_t> &counts,
+                                SelectionQueue &queue) {
+  for (std::size_t w = 0; w < keep.size(); ++w) {
+    uint64_t bits = keep[w];
+    while (bits) {
+      const std::size_t idx = (w << 6) + __builtin_ctzll(bits);
+      if (delta[idx] > 0) {
+        counts[idx] -= delta[idx];
+        queue.decrease_key(idx, delta[idx]);
+      }
+      bits &= bits - 1;
+    }
   }
-  keep_col[idx] = false;
 }
 
 //------------------------------------------------------------------------------
@@ -351,11 +572,16 @@ void GreedySolver::remove_col(const std::size_t idx) {
 // removed.
 //------------------------------------------------------------------------------
 void GreedySolver::update_rows(const std::size_t removed_col) {
-  for (std::size_t i = 0; i < num_rows; ++i) {
-    if (keep_row[i]) {
-      if (!data->is_data_na(i, removed_col)) {
-        --alphas[i];
-      }
+  const uint64_t *col = data->get_col_words(removed_col);
+
+  for (std::size_t w = 0; w < keep_row.size(); ++w) {
+    // Kept rows with a valid element in the removed column
+    uint64_t bits = col[w] & keep_row[w];
+    while (bits) {
+      const std::size_t i = (w << 6) + __builtin_ctzll(bits);
+      --alphas[i];
+      row_queue.decrease_key(i);
+      bits &= bits - 1;
     }
   }
 }
@@ -365,11 +591,16 @@ void GreedySolver::update_rows(const std::size_t removed_col) {
 // removed.
 //------------------------------------------------------------------------------
 void GreedySolver::update_cols(const std::size_t removed_row) {
-  for (std::size_t j = 0; j < num_cols; ++j) {
-    if (keep_col[j]) {
-      if (!data->is_data_na(removed_row,j)) {
-        --betas[j];
-      }
+  const uint64_t *row = data->get_row_words(removed_row);
+
+  for (std::size_t w = 0; w < keep_col.size(); ++w) {
+    // Kept columns with a valid element in the removed row
+    uint64_t bits = row[w] & keep_col[w];
+    while (bits) {
+      const std::size_t j = (w << 6) + __builtin_ctzll(bits);
+      --betas[j];
+      col_queue.decrease_key(j);
+      bits &= bits - 1;
     }
   }
 }
@@ -411,16 +642,9 @@ double GreedySolver::get_perc_miss_col(const std::size_t colIdx) const {
 // Returns a vector that contains the indices of columns that are both valid
 // and contain a missing element in the provided row.
 //------------------------------------------------------------------------------
-std::vector<std::size_t> GreedySolver::get_missing_cols(const std::size_t rowIdx) const {
+const std::vector<std::size_t> &GreedySolver::get_missing_cols(const std::size_t rowIdx) {
   assert(rowIdx < num_rows);
-  std::vector<std::size_t> missing;  
-
-  for (std::size_t j = 0; j < num_cols; ++j) {
-    if (keep_col[j] && data->is_data_na(rowIdx, j)) {
-      missing.push_back(j);
-    }
-  }
-
+  get_missing(data->get_row_words(rowIdx), keep_col);
   return missing;
 }
 
@@ -428,17 +652,110 @@ std::vector<std::size_t> GreedySolver::get_missing_cols(const std::size_t rowIdx
 // Returns a vector that contains the indices of rows that are both valid and
 // contain a missing element in the provided column.
 //------------------------------------------------------------------------------
-std::vector<std::size_t> GreedySolver::get_missing_rows(const std::size_t colIdx) const {
+const std::vector<std::size_t> &GreedySolver::get_missing_rows(const std::size_t colIdx) {
   assert(colIdx < num_cols);
-  std::vector<std::size_t> missing;  
+  get_missing(data->get_col_words(colIdx), keep_row);
+  return missing;
+}
 
-  for (std::size_t i = 0; i < num_rows; ++i) {
-    if (keep_row[i] && data->is_data_na(i, colIdx)) {
-      missing.push_back(i);
+//------------------------------------------------------------------------------
+// Stores the indices, in increasing order, of the kept items whose bit in
+// 'words' is clear in 'missing'. With a thread pool the items are first
+// counted per chunk of words, and each chunk then writes its indices at its
+// offset in 'missing'.
+//------------------------------------------------------------------------------
+void GreedySolver::get_missing(const uint64_t *words, const std::vector<uint64_t> &keep) {
+  const std::size_t num_chunks = get_num_chunks(keep.size(), min_words_per_chunk);
+
+  if (num_chunks <= 1) {
+    missing.clear();
+    for (std::size_t w = 0; w < keep.size(); ++w) {
+      uint64_t bits = ~words[w] & keep[w];
+      while (bits) {
+        missing.push_back((w << 6) + __builtin_ctzll(bits));
+        bits &= bits - 1;
+      }
     }
+    return;
   }
 
-  return missing;
+  auto count_chunk = [&](std::size_t k, std::size_t begin, std::size_t end) {
+    std::size_t count = 0;
+    for (std::size_t w = begin; w < end; ++w) {
+      count += __builtin_popcountll(~words[w] & keep[w]);
+    }
+    chunk_offsets[k + 1] = count;
+  };
+  run_chunks(keep.size(), min_words_per_chunk, count_chunk);
+
+  chunk_offsets[0] = 0;
+  for (std::size_t k = 0; k < num_chunks; ++k) {
+    chunk_offsets[k + 1] += chunk_offsets[k];
+  }
+  missing.resize(chunk_offsets[num_chunks]);
+
+  auto fill_chunk = [&](std::size_t k, std::size_t begin, std::size_t end) {
+    std::size_t pos = chunk_offsets[k];
+    for (std::size_t w = begin; w < end; ++w) {
+      uint64_t bits = ~words[w] & keep[w];
+      while (bits) {
+        missing[pos++] = (w << 6) + __builtin_ctzll(bits);
+        bits &= bits - 1;
+      }
+    }
+  };
+  run_chunks(keep.size(), min_words_per_chunk, fill_chunk);
+}
+
+//------------------------------------------------------------------------------
+// Returns the 'k' items of 'candidates' with the most valid elements, as
+// (index, count) pairs in decreasing order of count. Ties go to the lowest
+// index, the order a stable sort of the candidates would give, or to the
+// lowest of 'ranks' when it is not empty. Only the first 'k' items are fully
+// sorted.
+//------------------------------------------------------------------------------
+const std::vector<std::pair<std::size_t, std::size_t>> &
+GreedySolver::select_most_valid(const std::vector<std::size_t> &candidates,
+                                const std::vector<std::size_t> &counts,
+                                const std::vector<std::size_t> &ranks,
+                                const std::size_t k) {
+  assert(k <= candidates.size());
+  selected.clear();
+  for (auto idx : candidates) {
+    selected.push_back(std::make_pair(idx, counts[idx]));
+  }
+
+  if (ranks.empty()) {
+    sort_selected(k, mr_clean_utils::SortPairBySecondItemDecreasingFirstIncreasing());
+  } else {
+    sort_selected(k, [&ranks](const std::pair<std::size_t, std::size_t> &lhs,
+                              const std::pair<std::size_t, std::size_t> &rhs) {
+      return lhs.second > rhs.second || (lhs.second == rhs.second && ranks[lhs.first] < ranks[rhs.first]);
+    });
+  }
+
+  return selected;
+}
+
+//------------------------------------------------------------------------------
+// Returns the largest number of missing elements a row (or column) with
+// 'num_kept' kept elements can contain without its percent of missing data
+// exceeding 'max_perc_miss'. The boundary is found with the same floating
+// point test used by get_perc_miss_row/col, so both agree exactly.
+//------------------------------------------------------------------------------
+std::size_t GreedySolver::calc_max_num_missing(const std::size_t num_kept) const {
+  return mr_clean_utils::calc_max_num_missing(max_perc_miss, num_kept);
+}
+
+//------------------------------------------------------------------------------
+// A row violates the maximum percent missing when its number of valid elements
+// is below num_cols_kept - calc_max_num_missing(num_cols_kept), and similarly
+// for columns. Updates both queues after the number of kept rows or columns
+// changes.
+//------------------------------------------------------------------------------
+void GreedySolver::update_thresholds() {
+  row_queue.set_threshold(num_cols_kept - calc_max_num_missing(num_cols_kept));
+  col_queue.set_threshold(num_rows_kept - calc_max_num_missing(num_rows_kept));
 }
 
 //------------------------------------------------------------------------------
@@ -447,15 +764,7 @@ std::vector<std::size_t> GreedySolver::get_missing_rows(const std::size_t colIdx
 // percent missing.
 //------------------------------------------------------------------------------
 std::size_t GreedySolver::calc_num_rows_to_remove(const std::size_t colIdx) const {
-  double tmpNumMissing = static_cast<double>(get_num_missing_col(colIdx));  
-  std::size_t tmpNumRows = num_rows_kept;
-
-  while (tmpNumMissing / tmpNumRows > max_perc_miss) {
-    --tmpNumMissing;
-    --tmpNumRows;
-  }
-
-  return num_rows_kept - tmpNumRows;
+  return calc_num_to_remove(get_num_missing_col(colIdx), num_rows_kept);
 }
 
 //------------------------------------------------------------------------------
@@ -464,41 +773,87 @@ std::size_t GreedySolver::calc_num_rows_to_remove(const std::size_t colIdx) cons
 // percent missing.
 //------------------------------------------------------------------------------
 std::size_t GreedySolver::calc_num_cols_to_remove(const std::size_t idx) const {
-  double tmpNumMissing = static_cast<double>(get_num_missing_row(idx));
-  std::size_t tmpNumCols = num_cols_kept;
+  return calc_num_to_remove(get_num_missing_row(idx), num_cols_kept);
+}
+
+//------------------------------------------------------------------------------
+// Returns the smallest number r of missing elements that, removed along with
+// their rows (or columns), leaves (num_missing - r) / (num_kept - r) <=
+// max_perc_miss. Solving the inequality gives
+// r >= (num_missing - max_perc_miss * num_kept) / (1 - max_perc_miss); the
+// estimate is then corrected with the floating point test used before, which
+// is monotone in r, so the result matches removing one element at a time.
+//------------------------------------------------------------------------------
+std::size_t GreedySolver::calc_num_to_remove(const std::size_t num_missing,
+                                             const std::size_t num_kept) const {
+  auto over_limit = [&](std::size_t r) {
+    return static_cast<double>(num_missing - r) / (num_kept - r) > max_perc_miss;
+  };
 
-  while (tmpNumMissing / tmpNumCols > max_perc_miss) {
-    --tmpNumMissing;
-    --tmpNumCols;
+  std::size_t r = 0;
+  if (max_perc_miss < 1.0) {
+    const double estimate = std::ceil((num_missing - max_perc_miss * num_kept) / (1.0 - max_perc_miss));
+    r = std::min(num_missing, static_cast<std::size_t>(std::max(0.0, estimate)));
   }
 
-  return num_cols_kept - tmpNumCols;
+  while (r > 0 && !over_limit(r - 1)) {
+    --r;
+  }
+  while (r < num_missing && over_limit(r)) {
+    ++r;
+  }
+  return r;
 }
 
 //------------------------------------------------------------------------------
 // Returns the number of rows kept in the current solution.
 //------------------------------------------------------------------------------
 std::size_t GreedySolver::get_num_rows_kept() const {
-  std::size_t count = 0;
-  for (auto r : keep_row) {
-    if (r) {
-      ++count;
-    }
-  }
-  return count;
+  return num_rows_kept;
 }
 
 //------------------------------------------------------------------------------
 // Returns the number of columns kept in the current solution.
 //------------------------------------------------------------------------------
 std::size_t GreedySolver::get_num_cols_kept() const {
-  std::size_t count = 0;
-  for (auto c : keep_col) {
-    if (c) {
-      ++count;
-    }
-  }
-  return count;
+  return num_cols_kept;
+}
+
+//------------------------------------------------------------------------------
+// Returns the number of valid elements in the current solution.
+//------------------------------------------------------------------------------
+std::size_t GreedySolver::get_num_valid_kept() const {
+  return num_valid_kept;
+}
+
+//------------------------------------------------------------------------------
+// Returns the removal trace. Empty unless record_trace() was called.
+//------------------------------------------------------------------------------
+const RemovalTrace &GreedySolver::get_trace() const {
+  return trace;
+}
+
+//------------------------------------------------------------------------------
+// Returns true if the last solve() was given up, because it could not beat
+// the incumbent or reached a dimension limit.
+//------------------------------------------------------------------------------
+bool GreedySolver::is_abandoned() const {
+  return abandoned;
+}
+
+//------------------------------------------------------------------------------
+// Returns the number of heap allocations the calling thread made during the
+// last call to solve(), or 0 unless built with MRCLEAN_COUNT_ALLOCATIONS.
+//------------------------------------------------------------------------------
+std::size_t GreedySolver::get_num_solve_allocations() const {
+  return num_solve_allocations;
+}
+
+//------------------------------------------------------------------------------
+// Returns the maximum percent of missing data the solver cleans to.
+//------------------------------------------------------------------------------
+double GreedySolver::get_max_perc_miss() const {
+  return max_perc_miss;
 }
 
 //------------------------------------------------------------------------------
@@ -507,8 +862,8 @@ std::size_t GreedySolver::get_num_cols_kept() const {
 //------------------------------------------------------------------------------
 std::vector<bool> GreedySolver::get_rows_kept_as_bool() const {
   std::vector<bool> tmp(num_rows);
-  for (std::size_t i = 0; i < keep_row.size(); ++i) {
-    tmp[i] = keep_row[i];
+  for (std::size_t i = 0; i < num_rows; ++i) {
+    tmp[i] = is_row_kept(i);
   }
   return tmp;
 }
@@ -519,27 +874,16 @@ std::vector<bool> GreedySolver::get_rows_kept_as_bool() const {
 //------------------------------------------------------------------------------
 std::vector<bool> GreedySolver::get_cols_kept_as_bool() const {
   std::vector<bool> tmp(num_cols);
-  for (std::size_t j = 0; j < keep_col.size(); ++j) {
-    tmp[j] = keep_col[j];
+  for (std::size_t j = 0; j < num_cols; ++j) {
+    tmp[j] = is_col_kept(j);
   }
   return tmp;
 }
 
+//------------------------------------------------------------------------------
+// Returns true if all remaining rows and columns meet the max_perc_miss
+// requirement. The queues track the number of violators, so this is O(1).
+//------------------------------------------------------------------------------
 bool GreedySolver::matrix_cleaned() const {
-  // Check that all remaining rows meet max_perc_miss requirement
-  for (std::size_t i = 0; i < num_rows; ++i) {
-    if (keep_row[i] && (get_perc_miss_row(i) > max_perc_miss)) {
-      return false;
-    }
-  }
-
-  // Check that all remaining columns meet max_perc_miss requirement
-  for (std::size_t j = 0; j < num_cols; ++j) {
-    if (keep_col[j] && (get_perc_miss_col(j) > max_perc_miss)) {
-      return false;
-    }
-  }
-
-  // All remaining rows and columns meet requirements
-  return true;
+  return row_queue.get_num_violators() == 0 && col_queue.get_num_violators() == 0;
 }
\ No newline at end of file
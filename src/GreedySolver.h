@@ -1,42 +1,115 @@
 #ifndef GREEDY_SOLVER_H
 #define GREEDY_SOLVER_H
 
+#include <algorithm>
+#include <atomic>
+#include <functional>
 #include <vector>
 #include "BinContainer.h"
+#include "MrCleanUtils.h"
+#include "RemovalTrace.h"
+#include "SelectionQueue.h"
+#include "ThreadPool.h"
 
 class GreedySolver {
 private:
   const BinContainer *data;
+  ThreadPool *pool;
   const std::size_t num_rows;
   const std::size_t num_cols;
-  const double max_perc_miss;
+  double max_perc_miss;
   const std::size_t row_lb;
   const std::size_t col_lb;
   
   std::vector<std::size_t> alphas;
   std::vector<std::size_t> betas;
-  std::vector<bool> keep_row;
-  std::vector<bool> keep_col;
+  std::vector<uint64_t> keep_row;
+  std::vector<uint64_t> keep_col;
+  std::vector<uint64_t> removed_rows;
+  std::vector<uint64_t> removed_cols;
+  std::vector<std::size_t> row_delta;
+  std::vector<std::size_t> col_delta;
+  std::vector<std::size_t> chunk_offsets;
+  std::vector<std::size_t> idx_to_remove;
+  std::vector<std::size_t> missing;
+  std::vector<std::pair<std::size_t, std::size_t>> selected;
   std::size_t num_rows_kept;
   std::size_t num_cols_kept;
+  std::size_t num_valid_kept;
+  std::size_t num_solve_allocations;
+  bool tracing;
+  RemovalTrace trace;
+  std::vector<std::size_t> row_rank;
+  std::vector<std::size_t> col_rank;
+  const std::atomic<std::size_t> *incumbent;
+  bool abandoned;
+  SelectionQueue row_queue;
+  SelectionQueue col_queue;
   
+  bool is_row_kept(const std::size_t idx) const {
+    return mr_clean_utils::test_bit(keep_row.data(), idx);
+  }
+  bool is_col_kept(const std::size_t idx) const {
+    return mr_clean_utils::test_bit(keep_col.data(), idx);
+  }
+
   void calc_alphas();
   void calc_betas();
+
+  // Runs fn(chunk, begin, end) over [0, n) on the thread pool, or as a single
+  // chunk when the solver has no pool. The pool is handed a reference to 'fn',
+  // so no copy of the lambda is allocated.
+  template <typename Function>
+  void run_chunks(const std::size_t n, const std::size_t min_chunk, Function fn) const {
+    if (pool != nullptr) {
+      pool->parallel_for(n, min_chunk, std::ref(fn));
+    } else if (n > 0) {
+      fn(0, 0, n);
+    }
+  }
+
+  std::size_t get_num_chunks(const std::size_t n, const std::size_t min_chunk) const;
   void remove_row(const std::size_t idx);
   void remove_col(const std::size_t idx);
+  void remove_rows(const std::vector<std::size_t> &idx_to_remove);
+  void remove_cols(const std::vector<std::size_t> &idx_to_remove);
   void update_rows(const std::size_t removed_col);
   void update_cols(const std::size_t removed_row);
+  void apply_deltas(const std::vector<uint64_t> &keep,
+                    const std::vector<std::size_t> &delta,
+                    std::vector<std::size_t> &counts,
+                    SelectionQueue &queue);
   
   std::size_t get_num_missing_row(const std::size_t idx) const;
   std::size_t get_num_missing_col(const std::size_t idx) const;
   double get_perc_miss_row(const std::size_t idx) const;
   double get_perc_miss_col(const std::size_t idx) const;
 
-  std::vector<std::size_t> get_missing_cols(const std::size_t rowIdx) const;
-  std::vector<std::size_t> get_missing_rows(const std::size_t colIdx) const;
+  const std::vector<std::size_t> &get_missing_cols(const std::size_t rowIdx);
+  const std::vector<std::size_t> &get_missing_rows(const std::size_t colIdx);
+  void get_missing(const uint64_t *words, const std::vector<uint64_t> &keep);
+  const std::vector<std::pair<std::size_t, std::size_t>> &
+  select_most_valid(const std::vector<std::size_t> &candidates,
+                    const std::vector<std::size_t> &counts,
+                    const std::vector<std::size_t> &ranks,
+                    const std::size_t k);
+
+  // Moves the first 'k' entries of 'selected' in 'order' to the front, sorted
+  template <typename Order>
+  void sort_selected(const std::size_t k, Order order) {
+    if (k < selected.size()) {
+      std::nth_element(selected.begin(), selected.begin() + k, selected.end(), order);
+    }
+    std::sort(selected.begin(), selected.begin() + k, order);
+  }
+
+  std::size_t calc_max_num_missing(const std::size_t num_kept) const;
+  void update_thresholds();
 
   std::size_t calc_num_rows_to_remove(const std::size_t idx) const;
   std::size_t calc_num_cols_to_remove(const std::size_t idx) const;
+  std::size_t calc_num_to_remove(const std::size_t num_missing,
+                                 const std::size_t num_kept) const;
 
   bool matrix_cleaned() const;
   
@@ -44,15 +117,26 @@ public:
   GreedySolver(const BinContainer &_data,
                const double max_perc_miss,
                const std::size_t _row_lb,
-               const std::size_t _col_lb);
+               const std::size_t _col_lb,
+               ThreadPool *_pool = nullptr);
+  GreedySolver(const GreedySolver &start,
+               const double _max_perc_miss);
   ~GreedySolver();
 
+  void record_trace();
+  void randomize_ties(const uint64_t seed);
+  void set_incumbent(const std::atomic<std::size_t> *_incumbent);
   void solve();
 
   std::vector<bool> get_rows_kept_as_bool() const;
   std::vector<bool> get_cols_kept_as_bool() const; 
   std::size_t get_num_rows_kept() const;
   std::size_t get_num_cols_kept() const;
+  std::size_t get_num_valid_kept() const;
+  std::size_t get_num_solve_allocations() const;
+  const RemovalTrace &get_trace() const;
+  bool is_abandoned() const;
+  double get_max_perc_miss() const;
 };
 
 #endif
@@ -0,0 +1,114 @@
+#include "GzipReader.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+//------------------------------------------------------------------------------
+// Constructor. Opens 'file_name' for decompression. On failure is_open()
+// returns false. Chunks hold up to 'chunk_size' bytes unless a single line is
+// longer.
+//------------------------------------------------------------------------------
+GzipReader::GzipReader(const std::string &file_name,
+                       const std::size_t chunk_size) : file(nullptr),
+                                                       buffer(std::max<std::size_t>(1, chunk_size)),
+                                                       num_filled(0),
+                                                       num_consumed(0),
+                                                       offset(0),
+                                                       at_eof(false) {
+  file = gzopen(file_name.c_str(), "rb");
+  if (file != nullptr) {
+    gzbuffer(file, 1 << 18);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Destructor.
+//------------------------------------------------------------------------------
+GzipReader::~GzipReader() {
+  if (file != nullptr) {
+    gzclose(file);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Returns true if the file was opened.
+//------------------------------------------------------------------------------
+bool GzipReader::is_open() const {
+  return file != nullptr;
+}
+
+//------------------------------------------------------------------------------
+// Decompresses into the free end of the buffer until it is full or the end of
+// the file is reached.
+//------------------------------------------------------------------------------
+void GzipReader::fill() {
+  while (!at_eof && num_filled < buffer.size()) {
+    const std::size_t request = std::min<std::size_t>(buffer.size() - num_filled,
+                                                      std::numeric_limits<int>::max());
+    const int n = gzread(file, buffer.data() + num_filled, static_cast<unsigned>(request));
+    if (n < 0) {
+      int error;
+      const char *message = gzerror(file, &error);
+      throw std::runtime_error(std::string("Input file could not be decompressed (") + message + ").");
+    }
+    if (n == 0) {
+      at_eof = true;
+    }
+    num_filled += n;
+  }
+}
+
+//------------------------------------------------------------------------------
+// Sets [begin, end) to the next chunk of whole lines and 'chunk_offset' to its
+// position in the decompressed file. The last chunk may end in a line without
+// a newline. Returns false once the whole file has been handed out. The chunk
+// stays valid until the next call.
+//------------------------------------------------------------------------------
+bool GzipReader::next_chunk(const char *&begin, const char *&end, uint64_t &chunk_offset) {
+  // Move the partial line after the previous chunk to the front
+  if (num_consumed > 0) {
+    memmove(buffer.data(), buffer.data() + num_consumed, num_filled - num_consumed);
+    num_filled -= num_consumed;
+    offset += num_consumed;
+    num_consumed = 0;
+  }
+
+  while (true) {
+    fill();
+    const void *last_newline = memrchr(buffer.data(), '\n', num_filled);
+    if (last_newline != nullptr) {
+      num_consumed = static_cast<const char *>(last_newline) - buffer.data() + 1;
+      break;
+    }
+    if (at_eof) {
+      num_consumed = num_filled;
+      break;
+    }
+    // A single line fills the buffer
+    buffer.resize(2 * buffer.size());
+  }
+
+  if (num_consumed == 0) {
+    return false;
+  }
+  begin = buffer.data();
+  end = buffer.data() + num_consumed;
+  chunk_offset = offset;
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Returns true if 'file_name' starts with the gzip magic number.
+//------------------------------------------------------------------------------
+bool GzipReader::is_gzip_file(const std::string &file_name) {
+  FILE *input = fopen(file_name.c_str(), "rb");
+  if (input == nullptr) {
+    return false;
+  }
+  unsigned char magic[2] = {0, 0};
+  const bool is_gzip = fread(magic, 1, 2, input) == 2 && magic[0] == 0x1f && magic[1] == 0x8b;
+  fclose(input);
+  return is_gzip;
+}
@@ -0,0 +1,39 @@
+#ifndef GZIP_READER_H
+#define GZIP_READER_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <zlib.h>
+
+//------------------------------------------------------------------------------
+// Single forward pass over a gzip compressed text file. The decompressed bytes
+// are handed out in chunks of whole lines, so a line never straddles two
+// chunks. Only the current chunk and the partial line after it are held in
+// memory, and nothing is written to disk.
+//------------------------------------------------------------------------------
+class GzipReader {
+private:
+  gzFile file;
+  std::vector<char> buffer;
+  std::size_t num_filled;
+  std::size_t num_consumed;
+  uint64_t offset;
+  bool at_eof;
+
+  void fill();
+
+public:
+  GzipReader(const std::string &file_name, const std::size_t chunk_size = 1 << 22);
+  ~GzipReader();
+
+  GzipReader(const GzipReader &) = delete;
+  GzipReader &operator=(const GzipReader &) = delete;
+
+  bool is_open() const;
+  bool next_chunk(const char *&begin, const char *&end, uint64_t &chunk_offset);
+
+  static bool is_gzip_file(const std::string &file_name);
+};
+
+#endif
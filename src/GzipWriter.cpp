@@ -0,0 +1,155 @@
+#include "GzipWriter.h"
+#include <algorithm>
+#include <cerrno>
+#include <fcntl.h>
+#include <stdexcept>
+#include <unistd.h>
+#include <zlib.h>
+
+namespace {
+  bool write_all(const int fd, const char *bytes, std::size_t size) {
+    while (size > 0) {
+      const ssize_t n = write(fd, bytes, size);
+      if (n < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        return false;
+      }
+      bytes += n;
+      size -= n;
+    }
+    return true;
+  }
+}
+
+//------------------------------------------------------------------------------
+// Constructor. Creates or truncates 'file_name'. On failure is_open() returns
+// false.
+//------------------------------------------------------------------------------
+GzipWriter::GzipWriter(const std::string &file_name,
+                       const std::size_t _num_threads,
+                       const std::size_t _block_size) : fd(-1),
+                                                        failed(false),
+                                                        num_threads(std::max<std::size_t>(1, _num_threads)),
+                                                        block_size(std::max<std::size_t>(1, _block_size)),
+                                                        any_written(false) {
+  fd = open(file_name.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  block.reserve(block_size);
+}
+
+//------------------------------------------------------------------------------
+// Destructor. Finishes and closes the file if close() was not called.
+//------------------------------------------------------------------------------
+GzipWriter::~GzipWriter() {
+  close();
+}
+
+//------------------------------------------------------------------------------
+// Returns true if the file was opened.
+//------------------------------------------------------------------------------
+bool GzipWriter::is_open() const {
+  return fd >= 0;
+}
+
+//------------------------------------------------------------------------------
+// Appends bytes to the output.
+//------------------------------------------------------------------------------
+void GzipWriter::append(const char *bytes, const std::size_t size) {
+  std::size_t done = 0;
+  while (done < size) {
+    const std::size_t n = std::min(size - done, block_size - block.size());
+    block.append(bytes + done, n);
+    done += n;
+    if (block.size() >= block_size) {
+      submit_block();
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Starts compressing the current block. With one thread the block is
+// compressed and written right away. Otherwise up to 'num_threads' blocks are
+// compressed at a time, and the oldest is written once that many are pending.
+//------------------------------------------------------------------------------
+void GzipWriter::submit_block() {
+  if (num_threads == 1) {
+    std::string member;
+    compress_block(block.data(), block.size(), member);
+    failed = failed || !write_all(fd, member.data(), member.size());
+  } else {
+    if (pending.size() >= num_threads) {
+      write_next();
+    }
+    pending.push_back(std::async(std::launch::async, [](const std::string input) {
+      std::string member;
+      compress_block(input.data(), input.size(), member);
+      return member;
+    }, std::move(block)));
+  }
+  block.clear();
+  block.reserve(block_size);
+  any_written = true;
+}
+
+//------------------------------------------------------------------------------
+// Waits for the oldest pending block and writes it.
+//------------------------------------------------------------------------------
+void GzipWriter::write_next() {
+  const std::string member = pending.front().get();
+  pending.pop_front();
+  failed = failed || !write_all(fd, member.data(), member.size());
+}
+
+//------------------------------------------------------------------------------
+// Compresses the last block, writes every pending block and closes the file.
+// Returns false if compression or any write failed.
+//------------------------------------------------------------------------------
+bool GzipWriter::close() {
+  if (fd < 0) {
+    return false;
+  }
+  try {
+    // An empty output is still written as one (empty) member
+    if (!block.empty() || !any_written) {
+      submit_block();
+    }
+    while (!pending.empty()) {
+      write_next();
+    }
+  } catch (const std::exception &) {
+    failed = true;
+    pending.clear();
+  }
+  const bool closed = ::close(fd) == 0;
+  fd = -1;
+  return closed && !failed;
+}
+
+//------------------------------------------------------------------------------
+// Compresses [bytes, bytes + size) into a complete gzip member.
+//------------------------------------------------------------------------------
+void GzipWriter::compress_block(const char *bytes, const std::size_t size, std::string &member) {
+  z_stream stream;
+  stream.zalloc = Z_NULL;
+  stream.zfree = Z_NULL;
+  stream.opaque = Z_NULL;
+  // A window of 15 bits plus 16 selects the gzip wrapper. The fastest level
+  // keeps compression from dominating the write.
+  if (deflateInit2(&stream, Z_BEST_SPEED, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+    throw std::runtime_error("Could not initialize gzip compression.");
+  }
+
+  member.resize(deflateBound(&stream, size));
+  stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(bytes));
+  stream.avail_in = size;
+  stream.next_out = reinterpret_cast<Bytef *>(&member[0]);
+  stream.avail_out = member.size();
+  const int status = deflate(&stream, Z_FINISH);
+  member.resize(stream.total_out);
+  deflateEnd(&stream);
+
+  if (status != Z_STREAM_END) {
+    throw std::runtime_error("Could not compress output block.");
+  }
+}
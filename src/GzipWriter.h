@@ -0,0 +1,51 @@
+#ifndef GZIP_WRITER_H
+#define GZIP_WRITER_H
+
+#include <cstddef>
+#include <deque>
+#include <future>
+#include <string>
+
+//------------------------------------------------------------------------------
+// Gzip compressed output file. The output is cut into blocks that are
+// compressed independently, on up to 'num_threads' threads, into gzip members
+// that are written in order. A file of concatenated members is a valid gzip
+// file, which gzip, zcat and zlib read as a single stream.
+//------------------------------------------------------------------------------
+class GzipWriter {
+private:
+  int fd;
+  bool failed;
+  const std::size_t num_threads;
+  const std::size_t block_size;
+  std::string block;
+  std::deque<std::future<std::string>> pending;
+  bool any_written;
+
+  void submit_block();
+  void write_next();
+
+public:
+  GzipWriter(const std::string &file_name,
+             const std::size_t _num_threads = 1,
+             const std::size_t _block_size = 1 << 20);
+  ~GzipWriter();
+
+  GzipWriter(const GzipWriter &) = delete;
+  GzipWriter &operator=(const GzipWriter &) = delete;
+
+  bool is_open() const;
+
+  void put(const char c) {
+    block.push_back(c);
+    if (block.size() >= block_size) {
+      submit_block();
+    }
+  }
+  void append(const char *bytes, const std::size_t size);
+  bool close();
+
+  static void compress_block(const char *bytes, const std::size_t size, std::string &member);
+};
+
+#endif
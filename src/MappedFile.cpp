@@ -0,0 +1,87 @@
+#include "MappedFile.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+//------------------------------------------------------------------------------
+// Constructor. Maps 'file_name' read-only. On failure is_open() returns false.
+// An empty file is open, but has no mapping.
+//------------------------------------------------------------------------------
+MappedFile::MappedFile(const std::string &file_name) : fd(-1),
+                                                       map(nullptr),
+                                                       size(0) {
+  fd = open(file_name.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return;
+  }
+
+  struct stat sb;
+  if (fstat(fd, &sb) != 0) {
+    close(fd);
+    fd = -1;
+    return;
+  }
+
+  size = static_cast<std::size_t>(sb.st_size);
+  if (size == 0) {
+    return;
+  }
+
+  map = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (map == MAP_FAILED) {
+    map = nullptr;
+    size = 0;
+    close(fd);
+    fd = -1;
+    return;
+  }
+  madvise(map, size, MADV_SEQUENTIAL);
+}
+
+//------------------------------------------------------------------------------
+// Destructor.
+//------------------------------------------------------------------------------
+MappedFile::~MappedFile() {
+  if (map != nullptr) {
+    munmap(map, size);
+  }
+  if (fd >= 0) {
+    close(fd);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Returns true if the file was opened (and mapped, if not empty).
+//------------------------------------------------------------------------------
+bool MappedFile::is_open() const {
+  return fd >= 0;
+}
+
+//------------------------------------------------------------------------------
+// Returns the descriptor of the open file, or -1 if it could not be opened.
+//------------------------------------------------------------------------------
+int MappedFile::get_fd() const {
+  return fd;
+}
+
+//------------------------------------------------------------------------------
+// Returns the size of the file in bytes.
+//------------------------------------------------------------------------------
+std::size_t MappedFile::get_size() const {
+  return size;
+}
+
+//------------------------------------------------------------------------------
+// Returns a pointer to the first byte of the file.
+//------------------------------------------------------------------------------
+const char *MappedFile::begin() const {
+  return static_cast<const char *>(map);
+}
+
+//------------------------------------------------------------------------------
+// Returns a pointer one past the last byte of the file.
+//------------------------------------------------------------------------------
+const char *MappedFile::end() const {
+  return static_cast<const char *>(map) + size;
+}
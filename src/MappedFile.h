@@ -0,0 +1,26 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <string>
+
+class MappedFile {
+private:
+  int fd;
+  void *map;
+  std::size_t size;
+
+public:
+  MappedFile(const std::string &file_name);
+  ~MappedFile();
+
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  bool is_open() const;
+  int get_fd() const;
+  std::size_t get_size() const;
+  const char *begin() const;
+  const char *end() const;
+};
+
+#endif
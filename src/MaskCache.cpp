@@ -0,0 +1,270 @@
+#include "MaskCache.h"
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "MappedFile.h"
+
+namespace {
+  const uint64_t cache_magic = 0x314b53414d52434dULL; // "MCRMASK1"
+  const uint64_t cache_version = 1;
+  const uint64_t fnv_offset_basis = 0xcbf29ce484222325ULL;
+
+  // Number and size of the blocks of the data file that are hashed
+  const std::size_t num_hash_blocks = 16;
+  const std::size_t hash_block_size = 4096;
+
+  struct CacheHeader {
+    uint64_t magic;
+    uint64_t version;
+    uint64_t file_size;
+    int64_t mtime_sec;
+    int64_t mtime_nsec;
+    uint64_t content_hash;
+    uint64_t num_header_rows;
+    uint64_t num_header_cols;
+    uint64_t delim;
+    uint64_t key_size;
+    uint64_t num_rows;
+    uint64_t num_cols;
+    uint64_t row_stride;
+    uint64_t col_stride;
+    uint64_t offsets_pos;
+    uint64_t row_bits_pos;
+    uint64_t col_bits_pos;
+    uint64_t total_size;
+  };
+
+  uint64_t align_up(const uint64_t pos) {
+    return (pos + 63) & ~static_cast<uint64_t>(63);
+  }
+
+  bool write_padded(FILE *output, const void *bytes, const std::size_t size, uint64_t &pos) {
+    static const char zeros[64] = {0};
+    if (size > 0 && fwrite(bytes, 1, size, output) != size) {
+      return false;
+    }
+    pos += size;
+    const std::size_t padding = align_up(pos) - pos;
+    if (padding > 0 && fwrite(zeros, 1, padding, output) != padding) {
+      return false;
+    }
+    pos += padding;
+    return true;
+  }
+}
+
+//------------------------------------------------------------------------------
+// Constructor. Computes the cache key of 'data_file' and the name of its cache
+// file in 'cache_dir'. is_valid() is false if the data file cannot be read.
+//------------------------------------------------------------------------------
+MaskCache::MaskCache(const std::string &cache_dir,
+                     const std::string &_data_file,
+                     const std::string &na_symbol,
+                     const std::size_t _num_header_rows,
+                     const std::size_t _num_header_cols,
+                     const char _delim) : data_file(_data_file),
+                                          valid(false),
+                                          file_size(0),
+                                          mtime_sec(0),
+                                          mtime_nsec(0),
+                                          content_hash(0),
+                                          num_header_rows(_num_header_rows),
+                                          num_header_cols(_num_header_cols),
+                                          delim(static_cast<unsigned char>(_delim)) {
+  char path[PATH_MAX];
+  if (realpath(data_file.c_str(), path) == nullptr) {
+    return;
+  }
+
+  struct stat sb;
+  if (stat(path, &sb) != 0) {
+    return;
+  }
+  file_size = static_cast<uint64_t>(sb.st_size);
+  mtime_sec = sb.st_mtim.tv_sec;
+  mtime_nsec = sb.st_mtim.tv_nsec;
+
+  // Hash evenly spaced blocks of the content, which covers the whole file when
+  // it is small
+  MappedFile input(path);
+  if (!input.is_open()) {
+    return;
+  }
+  content_hash = fnv_offset_basis;
+  if (input.get_size() <= num_hash_blocks * hash_block_size) {
+    content_hash = hash_bytes(input.begin(), input.end(), content_hash);
+  } else {
+    const std::size_t last_start = input.get_size() - hash_block_size;
+    for (std::size_t b = 0; b < num_hash_blocks; ++b) {
+      const char *block = input.begin() + b * last_start / (num_hash_blocks - 1);
+      content_hash = hash_bytes(block, block + hash_block_size, content_hash);
+    }
+  }
+
+  key = std::string(path) + '\n' + na_symbol;
+
+  // Name the cache file after everything except the file state, so that a
+  // changed data file replaces its old cache file
+  const std::string name_key = key + '\n' + std::to_string(num_header_rows) + '\n' +
+                               std::to_string(num_header_cols) + '\n' + std::to_string(delim);
+  const uint64_t name_hash = hash_bytes(name_key.data(), name_key.data() + name_key.size(), fnv_offset_basis);
+  char name[32];
+  snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(name_hash));
+  cache_file = cache_dir + "/" + name + ".mrmask";
+
+  valid = true;
+}
+
+//------------------------------------------------------------------------------
+// Destructor.
+//------------------------------------------------------------------------------
+MaskCache::~MaskCache() {}
+
+//------------------------------------------------------------------------------
+// 64-bit FNV-1a hash of [begin, end), continuing from 'hash'.
+//------------------------------------------------------------------------------
+uint64_t MaskCache::hash_bytes(const char *begin, const char *end, uint64_t hash) {
+  for (const char *p = begin; p < end; ++p) {
+    hash ^= static_cast<unsigned char>(*p);
+    hash *= 0x100000001b3ULL;
+  }
+  return hash;
+}
+
+//------------------------------------------------------------------------------
+// Returns true if the cache key of the data file could be computed.
+//------------------------------------------------------------------------------
+bool MaskCache::is_valid() const {
+  return valid;
+}
+
+//------------------------------------------------------------------------------
+// Returns the path of the cache file.
+//------------------------------------------------------------------------------
+const std::string &MaskCache::get_cache_file() const {
+  return cache_file;
+}
+
+//------------------------------------------------------------------------------
+// Loads the mask and line offsets from the cache file. Returns false, leaving
+// 'data' and 'line_offsets' unchanged, if there is no cache file or its key
+// does not match the data file.
+//------------------------------------------------------------------------------
+bool MaskCache::load(BitMatrix &data, std::vector<uint64_t> &line_offsets) const {
+  if (!valid) {
+    return false;
+  }
+
+  MappedFile input(cache_file);
+  if (!input.is_open() || input.get_size() < sizeof(CacheHeader)) {
+    return false;
+  }
+
+  CacheHeader header;
+  memcpy(&header, input.begin(), sizeof(header));
+  if (header.magic != cache_magic ||
+      header.version != cache_version ||
+      header.file_size != file_size ||
+      header.mtime_sec != mtime_sec ||
+      header.mtime_nsec != mtime_nsec ||
+      header.content_hash != content_hash ||
+      header.num_header_rows != num_header_rows ||
+      header.num_header_cols != num_header_cols ||
+      header.delim != delim ||
+      header.key_size != key.size() ||
+      header.total_size != input.get_size()) {
+    return false;
+  }
+
+  if (sizeof(header) + key.size() > input.get_size() ||
+      memcmp(input.begin() + sizeof(header), key.data(), key.size()) != 0) {
+    return false;
+  }
+
+  // Check the layout before copying
+  if (header.row_stride != BitMatrix::calc_stride(header.num_cols) ||
+      header.col_stride != BitMatrix::calc_stride(header.num_rows) ||
+      header.offsets_pos + (header.num_rows + 1) * sizeof(uint64_t) > header.row_bits_pos ||
+      header.row_bits_pos + header.num_rows * header.row_stride * sizeof(uint64_t) > header.col_bits_pos ||
+      header.col_bits_pos + header.num_cols * header.col_stride * sizeof(uint64_t) > header.total_size ||
+      header.offsets_pos % 64 != 0 ||
+      header.row_bits_pos % 64 != 0 ||
+      header.col_bits_pos % 64 != 0) {
+    return false;
+  }
+
+  const uint64_t *offsets = reinterpret_cast<const uint64_t *>(input.begin() + header.offsets_pos);
+  line_offsets.assign(offsets, offsets + header.num_rows + 1);
+  data.assign(header.num_rows,
+              header.num_cols,
+              reinterpret_cast<const uint64_t *>(input.begin() + header.row_bits_pos),
+              reinterpret_cast<const uint64_t *>(input.begin() + header.col_bits_pos));
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Writes the mask, which must have its column-major copy built, and the line
+// offsets to the cache file. The file is written under a temporary name and
+// renamed, so readers never see a partial file. Returns false on failure.
+//------------------------------------------------------------------------------
+bool MaskCache::save(const BitMatrix &data, const std::vector<uint64_t> &line_offsets) const {
+  if (!valid || line_offsets.size() != data.get_num_rows() + 1) {
+    return false;
+  }
+
+  const std::string dir = cache_file.substr(0, cache_file.find_last_of('/'));
+  if (mkdir(dir.c_str(), 0755) != 0 && errno != EEXIST) {
+    return false;
+  }
+
+  CacheHeader header;
+  memset(&header, 0, sizeof(header));
+  header.magic = cache_magic;
+  header.version = cache_version;
+  header.file_size = file_size;
+  header.mtime_sec = mtime_sec;
+  header.mtime_nsec = mtime_nsec;
+  header.content_hash = content_hash;
+  header.num_header_rows = num_header_rows;
+  header.num_header_cols = num_header_cols;
+  header.delim = delim;
+  header.key_size = key.size();
+  header.num_rows = data.get_num_rows();
+  header.num_cols = data.get_num_cols();
+  header.row_stride = data.get_row_stride();
+  header.col_stride = data.get_col_stride();
+
+  const std::size_t offsets_size = line_offsets.size() * sizeof(uint64_t);
+  const std::size_t row_bits_size = header.num_rows * header.row_stride * sizeof(uint64_t);
+  const std::size_t col_bits_size = header.num_cols * header.col_stride * sizeof(uint64_t);
+  header.offsets_pos = align_up(sizeof(header) + key.size());
+  header.row_bits_pos = align_up(header.offsets_pos + offsets_size);
+  header.col_bits_pos = align_up(header.row_bits_pos + row_bits_size);
+  header.total_size = align_up(header.col_bits_pos + col_bits_size);
+
+  const std::string tmp_file = cache_file + ".tmp." + std::to_string(getpid());
+  FILE *output = fopen(tmp_file.c_str(), "wb");
+  if (output == nullptr) {
+    return false;
+  }
+
+  uint64_t pos = 0;
+  bool ok = fwrite(&header, 1, sizeof(header), output) == sizeof(header);
+  pos += sizeof(header);
+  ok = ok && write_padded(output, key.data(), key.size(), pos);
+  ok = ok && write_padded(output, line_offsets.data(), offsets_size, pos);
+  ok = ok && write_padded(output, data.get_row_major(), row_bits_size, pos);
+  ok = ok && write_padded(output, data.get_col_major(), col_bits_size, pos);
+  ok = (fclose(output) == 0) && ok && pos == header.total_size;
+
+  if (!ok || rename(tmp_file.c_str(), cache_file.c_str()) != 0) {
+    remove(tmp_file.c_str());
+    return false;
+  }
+  return true;
+}
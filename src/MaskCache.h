@@ -0,0 +1,52 @@
+#ifndef MASK_CACHE_H
+#define MASK_CACHE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "BitMatrix.h"
+
+//------------------------------------------------------------------------------
+// On-disk cache of the parsed validity mask of one data file. A cache file
+// holds a fixed header, the cache key, the byte offset of every data line and
+// both layouts of the bit matrix, each section starting on a 64-byte boundary
+// so the file can be mapped and copied without decoding.
+//
+// A cache file is only used when its key matches: the data file's canonical
+// path, size, modification time and a hash of sampled blocks of its content,
+// plus the NA symbol, the number of header rows and columns and the field
+// separator.
+//------------------------------------------------------------------------------
+class MaskCache {
+private:
+  std::string data_file;
+  std::string cache_file;
+  std::string key;
+  bool valid;
+  uint64_t file_size;
+  int64_t mtime_sec;
+  int64_t mtime_nsec;
+  uint64_t content_hash;
+  uint64_t num_header_rows;
+  uint64_t num_header_cols;
+  uint64_t delim;
+
+  static uint64_t hash_bytes(const char *begin, const char *end, uint64_t hash);
+
+public:
+  MaskCache(const std::string &cache_dir,
+            const std::string &_data_file,
+            const std::string &na_symbol,
+            const std::size_t _num_header_rows,
+            const std::size_t _num_header_cols,
+            const char _delim);
+  ~MaskCache();
+
+  bool is_valid() const;
+  const std::string &get_cache_file() const;
+
+  bool load(BitMatrix &data, std::vector<uint64_t> &line_offsets) const;
+  bool save(const BitMatrix &data, const std::vector<uint64_t> &line_offsets) const;
+};
+
+#endif
@@ -1,9 +1,99 @@
 #ifndef MR_CLEAN_UTILS_H
 #define MR_CLEAN_UTILS_H
 
+#include <cstdint>
+#include <cstddef>
+#include <random>
+#include <utility>
 #include <vector>
 
 namespace mr_clean_utils { 
+  // Number of 64-bit words needed to hold 'num_bits' bits
+  inline std::size_t num_words(const std::size_t num_bits) {
+    return (num_bits + 63) >> 6;
+  }
+
+  inline bool test_bit(const uint64_t *words, const std::size_t idx) {
+    return (words[idx >> 6] >> (idx & 63)) & 1;
+  }
+
+  inline void set_bit(uint64_t *words, const std::size_t idx) {
+    words[idx >> 6] |= (uint64_t(1) << (idx & 63));
+  }
+
+  inline void clear_bit(uint64_t *words, const std::size_t idx) {
+    words[idx >> 6] &= ~(uint64_t(1) << (idx & 63));
+  }
+
+  // Returns a word vector with the first 'num_bits' bits set
+  inline std::vector<uint64_t> make_full_mask(const std::size_t num_bits) {
+    std::vector<uint64_t> words(num_words(num_bits), ~uint64_t(0));
+    if (num_bits & 63) {
+      words.back() = (uint64_t(1) << (num_bits & 63)) - 1;
+    }
+    return words;
+  }
+
+  // Adds 'idx' to the bucket of 'value', recording its position in 'pos'
+  inline void add_to_bucket(std::vector<std::vector<std::size_t>> &buckets,
+                            std::vector<std::size_t> &pos,
+                            const std::size_t value,
+                            const std::size_t idx) {
+    pos[idx] = buckets[value].size();
+    buckets[value].push_back(idx);
+  }
+
+  // Removes 'idx' from the bucket of 'value' by moving the last entry of the
+  // bucket into its place
+  inline void remove_from_bucket(std::vector<std::vector<std::size_t>> &buckets,
+                                 std::vector<std::size_t> &pos,
+                                 const std::size_t value,
+                                 const std::size_t idx) {
+    std::vector<std::size_t> &bucket = buckets[value];
+    const std::size_t last = bucket.back();
+    bucket[pos[idx]] = last;
+    pos[last] = pos[idx];
+    bucket.pop_back();
+  }
+
+  // Random permutation of 0..n-1 drawn from 'seed'. The shuffle is written out
+  // instead of using std::shuffle, whose result depends on the standard
+  // library, so a seed gives the same permutation everywhere.
+  inline std::vector<std::size_t> make_random_ranks(const std::size_t n, const uint64_t seed) {
+    std::vector<std::size_t> ranks(n);
+    for (std::size_t i = 0; i < n; ++i) {
+      ranks[i] = i;
+    }
+
+    std::mt19937_64 rng(seed);
+    for (std::size_t i = n; i > 1; --i) {
+      std::swap(ranks[i - 1], ranks[rng() % i]);
+    }
+    return ranks;
+  }
+
+  // Largest number of missing elements out of 'num_kept' that is within
+  // 'max_perc_miss', using the same floating point test as the percentages
+  inline std::size_t calc_max_num_missing(const double max_perc_miss, const std::size_t num_kept) {
+    if (num_kept == 0) {
+      return 0;
+    }
+
+    std::size_t max_missing = num_kept;
+    if (max_perc_miss * num_kept < num_kept) {
+      max_missing = static_cast<std::size_t>(max_perc_miss * num_kept);
+    }
+    while (max_missing < num_kept &&
+           static_cast<double>(max_missing + 1) / num_kept <= max_perc_miss) {
+      ++max_missing;
+    }
+    while (max_missing > 0 &&
+           static_cast<double>(max_missing) / num_kept > max_perc_miss) {
+      --max_missing;
+    }
+    return max_missing;
+  }
+
  struct SortPairByFirstItemDecreasing
   {
     template<typename T, typename U>
@@ -31,6 +121,17 @@ namespace mr_clean_utils {
     }
   };
 
+  // Same as SortPairBySecondItemDecreasing, with ties going to the smaller
+  // first item
+  struct SortPairBySecondItemDecreasingFirstIncreasing
+  {
+    template<typename T, typename U>
+    bool operator()(const std::pair<T, U> &lhs, const std::pair<T, U> &rhs) const
+    {
+      return lhs.second > rhs.second || (lhs.second == rhs.second && lhs.first < rhs.first);
+    }
+  };
+
   struct SortPairBySecondItemIncreasing
   {
     template<typename T, typename U>
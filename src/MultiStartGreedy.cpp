@@ -0,0 +1,182 @@
+#include "MultiStartGreedy.h"
+#include "AddColGreedy.h"
+#include "AddRowGreedy.h"
+#include "GreedySolver.h"
+#include "Timer.h"
+
+namespace {
+  // Solvers run by each start, in the order their ties are broken
+  const std::size_t num_start_solvers = 3;
+
+  // Seed of start 'start', mixed so that nearby seeds give unrelated orders
+  uint64_t get_start_seed(const uint64_t seed, const std::size_t start) {
+    uint64_t z = seed + (start + 1) * 0x9e3779b97f4a7c15ULL;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Constructor. A '_time_budget' of 0 runs every start.
+//------------------------------------------------------------------------------
+MultiStartGreedy::MultiStartGreedy(const BinContainer &_data,
+                                   const double _max_perc_miss,
+                                   const std::size_t _row_lb,
+                                   const std::size_t _col_lb,
+                                   const uint64_t _seed,
+                                   const std::size_t _num_starts,
+                                   const double _time_budget) : data(&_data),
+                                                                max_perc_miss(_max_perc_miss),
+                                                                row_lb(_row_lb),
+                                                                col_lb(_col_lb),
+                                                                seed(_seed),
+                                                                num_starts(_num_starts),
+                                                                time_budget(_time_budget),
+                                                                incumbent(0),
+                                                                best_order(0),
+                                                                num_started(0),
+                                                                num_abandoned(0) {}
+
+//------------------------------------------------------------------------------
+// Destructor.
+//------------------------------------------------------------------------------
+MultiStartGreedy::~MultiStartGreedy() {}
+
+//------------------------------------------------------------------------------
+// Runs the starts on 'pool', or on the calling thread without one, trying to
+// beat the solution given by 'rows_to_keep' and 'cols_to_keep'.
+//------------------------------------------------------------------------------
+void MultiStartGreedy::solve(const std::vector<bool> &rows_to_keep,
+                             const std::vector<bool> &cols_to_keep,
+                             ThreadPool *pool) {
+  best_rows = rows_to_keep;
+  best_cols = cols_to_keep;
+  best_order = 0;
+  incumbent = data->get_num_valid_data_kept(rows_to_keep, cols_to_keep);
+
+  Timer timer(true);
+  std::atomic<std::size_t> next(0);
+  auto run = [&](std::size_t, std::size_t, std::size_t) {
+    std::size_t start;
+    while ((start = next++) < num_starts) {
+      if (time_budget > 0 && timer.elapsed_wall_time() >= time_budget) {
+        break;
+      }
+      ++num_started;
+      run_start(start);
+    }
+  };
+
+  if (pool != nullptr) {
+    pool->parallel_for(pool->get_num_threads(), 1, run);
+  } else {
+    run(0, 0, 1);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Runs the solvers of 'start' with ties broken in orders drawn from its seed.
+//------------------------------------------------------------------------------
+void MultiStartGreedy::run_start(const std::size_t start) {
+  const uint64_t start_seed = get_start_seed(seed, start);
+  const std::size_t order = 1 + start * num_start_solvers;
+
+  GreedySolver greedy_solver(*data, max_perc_miss, row_lb, col_lb);
+  greedy_solver.randomize_ties(start_seed);
+  greedy_solver.set_incumbent(&incumbent);
+  greedy_solver.solve();
+  if (greedy_solver.is_abandoned()) {
+    ++num_abandoned;
+  } else {
+    update_best(order, greedy_solver.get_num_valid_kept(),
+                greedy_solver.get_rows_kept_as_bool(), greedy_solver.get_cols_kept_as_bool());
+  }
+
+  if (max_perc_miss > 0) {
+    return;
+  }
+
+  AddRowGreedy ar_greedy(*data, row_lb, col_lb);
+  AddColGreedy ac_greedy(*data, row_lb, col_lb);
+  AddRowGreedy *add_greedy[2] = {&ar_greedy, &ac_greedy};
+  for (std::size_t k = 0; k < 2; ++k) {
+    add_greedy[k]->randomize_ties(start_seed + k + 1);
+    add_greedy[k]->set_incumbent(&incumbent);
+    add_greedy[k]->solve();
+    if (add_greedy[k]->has_solution()) {
+      update_best(order + k + 1, add_greedy[k]->get_num_rows_to_keep() * add_greedy[k]->get_num_cols_to_keep(),
+                  add_greedy[k]->get_rows_to_keep(), add_greedy[k]->get_cols_to_keep());
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Keeps the solution of the solver at 'order' if it has more valid elements
+// than the best so far, or as many and an earlier order.
+//------------------------------------------------------------------------------
+void MultiStartGreedy::update_best(const std::size_t order,
+                                   const std::size_t num_valid,
+                                   const std::vector<bool> &rows,
+                                   const std::vector<bool> &cols) {
+  std::lock_guard<std::mutex> lock(best_mutex);
+  if (num_valid > incumbent || (num_valid == incumbent && order < best_order)) {
+    best_order = order;
+    best_rows = rows;
+    best_cols = cols;
+    incumbent = num_valid;
+  }
+}
+
+//------------------------------------------------------------------------------
+// Returns true if a start found a better solution than the one given.
+//------------------------------------------------------------------------------
+bool MultiStartGreedy::is_improved() const {
+  return best_order > 0;
+}
+
+//------------------------------------------------------------------------------
+// Returns a boolean vector where elements are 'true' if the corresponding row
+// is kept in the best solution.
+//------------------------------------------------------------------------------
+std::vector<bool> MultiStartGreedy::get_rows_to_keep() const {
+  return best_rows;
+}
+
+//------------------------------------------------------------------------------
+// Returns a boolean vector where elements are 'true' if the corresponding
+// column is kept in the best solution.
+//------------------------------------------------------------------------------
+std::vector<bool> MultiStartGreedy::get_cols_to_keep() const {
+  return best_cols;
+}
+
+//------------------------------------------------------------------------------
+// Returns the number of valid elements in the best solution.
+//------------------------------------------------------------------------------
+std::size_t MultiStartGreedy::get_num_valid_kept() const {
+  return incumbent;
+}
+
+//------------------------------------------------------------------------------
+// Returns the start, counted from 1, that found the best solution, or 0 if it
+// is the one given.
+//------------------------------------------------------------------------------
+std::size_t MultiStartGreedy::get_best_start() const {
+  return best_order == 0 ? 0 : (best_order - 1) / num_start_solvers + 1;
+}
+
+//------------------------------------------------------------------------------
+// Returns the number of starts run.
+//------------------------------------------------------------------------------
+std::size_t MultiStartGreedy::get_num_started() const {
+  return num_started;
+}
+
+//------------------------------------------------------------------------------
+// Returns the number of greedy solves given up because they could not reach
+// the best solution.
+//------------------------------------------------------------------------------
+std::size_t MultiStartGreedy::get_num_abandoned() const {
+  return num_abandoned;
+}
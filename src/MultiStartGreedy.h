@@ -0,0 +1,72 @@
+#ifndef MULTI_START_GREEDY_H
+#define MULTI_START_GREEDY_H
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+#include "BinContainer.h"
+#include "ThreadPool.h"
+
+//------------------------------------------------------------------------------
+// Runs the greedy solvers again with their ties broken in orders drawn from a
+// seed, to look for a better solution than the deterministic run. Each start
+// runs the greedy solver and, without missing data, the add-row and
+// add-column greedy solvers. Idle threads claim the next start, and all
+// starts share the best number of valid elements found so far, so a start is
+// given up as soon as it cannot reach it.
+//
+// A start is only given up when it cannot even tie the best, and ties go to
+// the given solution, then to the earliest start, so the result depends only
+// on the seed and the number of starts, not on the threads. With a time
+// budget, starts not begun when it runs out are skipped, and the result
+// depends on how many were run.
+//------------------------------------------------------------------------------
+class MultiStartGreedy {
+private:
+  const BinContainer *data;
+  const double max_perc_miss;
+  const std::size_t row_lb;
+  const std::size_t col_lb;
+  const uint64_t seed;
+  const std::size_t num_starts;
+  const double time_budget;
+
+  std::atomic<std::size_t> incumbent;
+  std::mutex best_mutex;
+  std::size_t best_order;
+  std::vector<bool> best_rows;
+  std::vector<bool> best_cols;
+  std::atomic<std::size_t> num_started;
+  std::atomic<std::size_t> num_abandoned;
+
+  void run_start(const std::size_t start);
+  void update_best(const std::size_t order,
+                   const std::size_t num_valid,
+                   const std::vector<bool> &rows,
+                   const std::vector<bool> &cols);
+
+public:
+  MultiStartGreedy(const BinContainer &_data,
+                   const double _max_perc_miss,
+                   const std::size_t _row_lb,
+                   const std::size_t _col_lb,
+                   const uint64_t _seed,
+                   const std::size_t _num_starts,
+                   const double _time_budget);
+  ~MultiStartGreedy();
+
+  void solve(const std::vector<bool> &rows_to_keep,
+             const std::vector<bool> &cols_to_keep,
+             ThreadPool *pool);
+
+  bool is_improved() const;
+  std::vector<bool> get_rows_to_keep() const;
+  std::vector<bool> get_cols_to_keep() const;
+  std::size_t get_num_valid_kept() const;
+  std::size_t get_best_start() const;
+  std::size_t get_num_started() const;
+  std::size_t get_num_abandoned() const;
+};
+
+#endif
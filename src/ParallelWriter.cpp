@@ -0,0 +1,139 @@
+#include "ParallelWriter.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <fcntl.h>
+#include <mutex>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+#include "GzipWriter.h"
+
+namespace {
+  bool pwrite_all(const int fd, const char *bytes, std::size_t size, off_t offset) {
+    while (size > 0) {
+      const ssize_t n = pwrite(fd, bytes, size, offset);
+      if (n < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        return false;
+      }
+      bytes += n;
+      size -= n;
+      offset += n;
+    }
+    return true;
+  }
+}
+
+//------------------------------------------------------------------------------
+// Constructor. Creates or truncates 'file_name'. On failure is_open() returns
+// false.
+//------------------------------------------------------------------------------
+ParallelWriter::ParallelWriter(const std::string &file_name,
+                               const std::size_t _num_threads,
+                               const bool _compress) : fd(-1),
+                                                       num_threads(std::max<std::size_t>(1, _num_threads)),
+                                                       compress(_compress),
+                                                       failed(false) {
+  fd = open(file_name.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+}
+
+//------------------------------------------------------------------------------
+// Destructor. Closes the file if close() was not called.
+//------------------------------------------------------------------------------
+ParallelWriter::~ParallelWriter() {
+  close();
+}
+
+//------------------------------------------------------------------------------
+// Returns true if the file was opened.
+//------------------------------------------------------------------------------
+bool ParallelWriter::is_open() const {
+  return fd >= 0;
+}
+
+//------------------------------------------------------------------------------
+// Appends blocks 0 to 'num_blocks' - 1 to the file, in that order. 'format' is
+// called once per block, from up to 'num_threads' threads at a time, and must
+// only append to the buffer it is given.
+//------------------------------------------------------------------------------
+void ParallelWriter::write_blocks(const std::size_t num_blocks, const BlockFunction &format) {
+  if (fd < 0 || num_blocks == 0) {
+    return;
+  }
+
+  off_t file_end = lseek(fd, 0, SEEK_END);
+  if (file_end < 0) {
+    failed = true;
+    return;
+  }
+
+  std::atomic<std::size_t> next_block(0);
+  std::mutex mutex;
+  std::condition_variable placed;
+  std::size_t num_placed = 0;
+  std::atomic<bool> write_failed(false);
+
+  auto work = [&]() {
+    BlockBuffer buffer;
+    std::string member;
+    std::size_t k;
+    while ((k = next_block++) < num_blocks) {
+      buffer.clear();
+      format(k, buffer);
+
+      const char *bytes = buffer.data();
+      std::size_t size = buffer.size();
+      if (compress) {
+        GzipWriter::compress_block(bytes, size, member);
+        bytes = member.data();
+        size = member.size();
+      }
+
+      // Blocks are claimed in order, so the thread holding block k - 1 never
+      // waits on this one
+      off_t offset;
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        placed.wait(lock, [&]() { return num_placed == k; });
+        offset = file_end;
+        file_end += size;
+        ++num_placed;
+      }
+      placed.notify_all();
+
+      if (!pwrite_all(fd, bytes, size, offset)) {
+        write_failed = true;
+      }
+    }
+  };
+
+  std::vector<std::thread> workers;
+  for (std::size_t t = 1; t < std::min(num_threads, num_blocks); ++t) {
+    workers.emplace_back(work);
+  }
+  work();
+  for (auto &w : workers) {
+    w.join();
+  }
+
+  failed = failed || write_failed;
+  if (lseek(fd, file_end, SEEK_SET) < 0) {
+    failed = true;
+  }
+}
+
+//------------------------------------------------------------------------------
+// Closes the file. Returns false if any write failed.
+//------------------------------------------------------------------------------
+bool ParallelWriter::close() {
+  if (fd < 0) {
+    return false;
+  }
+  const bool closed = ::close(fd) == 0;
+  fd = -1;
+  return closed && !failed;
+}
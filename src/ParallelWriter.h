@@ -0,0 +1,71 @@
+#ifndef PARALLEL_WRITER_H
+#define PARALLEL_WRITER_H
+
+#include <cstddef>
+#include <functional>
+#include <string>
+
+//------------------------------------------------------------------------------
+// In-memory output of one block of a ParallelWriter.
+//------------------------------------------------------------------------------
+class BlockBuffer {
+private:
+  std::string bytes;
+
+public:
+  void put(const char c) {
+    bytes.push_back(c);
+  }
+  void append(const char *first, const std::size_t size) {
+    bytes.append(first, size);
+  }
+  void append(const std::string &s) {
+    bytes.append(s);
+  }
+  void clear() {
+    bytes.clear();
+  }
+  const char *data() const {
+    return bytes.data();
+  }
+  std::size_t size() const {
+    return bytes.size();
+  }
+};
+
+//------------------------------------------------------------------------------
+// Output file made of numbered blocks that are formatted concurrently. Worker
+// threads claim blocks in increasing order and format each into a private
+// buffer. Once a block is formatted and every earlier block has been given its
+// place, the block's file offset is the end of the previous one, and it is
+// written there with pwrite(2) while later blocks are still being formatted.
+// The file is the same as if the blocks were formatted and written one after
+// the other, and at most one buffer per thread is held in memory. When
+// 'compress' is set, each block is written as a gzip member, compressed by the
+// thread that formatted it.
+//------------------------------------------------------------------------------
+class ParallelWriter {
+public:
+  typedef std::function<void(std::size_t block, BlockBuffer &buffer)> BlockFunction;
+
+private:
+  int fd;
+  const std::size_t num_threads;
+  const bool compress;
+  bool failed;
+
+public:
+  ParallelWriter(const std::string &file_name,
+                 const std::size_t _num_threads,
+                 const bool _compress = false);
+  ~ParallelWriter();
+
+  ParallelWriter(const ParallelWriter &) = delete;
+  ParallelWriter &operator=(const ParallelWriter &) = delete;
+
+  bool is_open() const;
+  void write_blocks(const std::size_t num_blocks, const BlockFunction &format);
+  bool close();
+};
+
+#endif
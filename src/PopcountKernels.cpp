@@ -0,0 +1,355 @@
+#include "PopcountKernels.h"
+#include <algorithm>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define MRCLEAN_X86
+#endif
+
+namespace {
+  typedef std::size_t (*CountFn)(const uint64_t *, const std::size_t);
+  typedef std::size_t (*CountAndFn)(const uint64_t *, const uint64_t *, const std::size_t);
+
+  // Inputs shorter than this many words do not fill a Harley-Seal block
+  const std::size_t harley_seal_min_words = 64;
+
+  //----------------------------------------------------------------------------
+  // Portable fallback.
+  //----------------------------------------------------------------------------
+  std::size_t count_generic(const uint64_t *a, const std::size_t n) {
+    std::size_t total = 0;
+    for (std::size_t w = 0; w < n; ++w) {
+      total += __builtin_popcountll(a[w]);
+    }
+    return total;
+  }
+
+  std::size_t count_and_generic(const uint64_t *a, const uint64_t *b, const std::size_t n) {
+    std::size_t total = 0;
+    for (std::size_t w = 0; w < n; ++w) {
+      total += __builtin_popcountll(a[w] & b[w]);
+    }
+    return total;
+  }
+
+#ifdef MRCLEAN_X86
+  //----------------------------------------------------------------------------
+  // Hardware POPCNT, unrolled by four to hide the instruction latency.
+  //----------------------------------------------------------------------------
+  __attribute__((target("popcnt")))
+  std::size_t count_popcnt(const uint64_t *a, const std::size_t n) {
+    uint64_t c0 = 0, c1 = 0, c2 = 0, c3 = 0;
+    std::size_t w = 0;
+    for (; w + 4 <= n; w += 4) {
+      c0 += __builtin_popcountll(a[w]);
+      c1 += __builtin_popcountll(a[w + 1]);
+      c2 += __builtin_popcountll(a[w + 2]);
+      c3 += __builtin_popcountll(a[w + 3]);
+    }
+    for (; w < n; ++w) {
+      c0 += __builtin_popcountll(a[w]);
+    }
+    return c0 + c1 + c2 + c3;
+  }
+
+  __attribute__((target("popcnt")))
+  std::size_t count_and_popcnt(const uint64_t *a, const uint64_t *b, const std::size_t n) {
+    uint64_t c0 = 0, c1 = 0, c2 = 0, c3 = 0;
+    std::size_t w = 0;
+    for (; w + 4 <= n; w += 4) {
+      c0 += __builtin_popcountll(a[w] & b[w]);
+      c1 += __builtin_popcountll(a[w + 1] & b[w + 1]);
+      c2 += __builtin_popcountll(a[w + 2] & b[w + 2]);
+      c3 += __builtin_popcountll(a[w + 3] & b[w + 3]);
+    }
+    for (; w < n; ++w) {
+      c0 += __builtin_popcountll(a[w] & b[w]);
+    }
+    return c0 + c1 + c2 + c3;
+  }
+
+  //----------------------------------------------------------------------------
+  // Popcount of each 64-bit lane of a 256-bit vector using a nibble lookup
+  // table (Mula et al.).
+  //----------------------------------------------------------------------------
+  __attribute__((target("avx2")))
+  inline __m256i popcount_256(const __m256i v) {
+    const __m256i lookup = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                            0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m256i low_mask = _mm256_set1_epi8(0x0f);
+    const __m256i lo = _mm256_and_si256(v, low_mask);
+    const __m256i hi = _mm256_and_si256(_mm256_srli_epi16(v, 4), low_mask);
+    const __m256i bytes = _mm256_add_epi8(_mm256_shuffle_epi8(lookup, lo),
+                                          _mm256_shuffle_epi8(lookup, hi));
+    return _mm256_sad_epu8(bytes, _mm256_setzero_si256());
+  }
+
+  //----------------------------------------------------------------------------
+  // Carry-save adder: (h, l) = a + b + c, bitwise.
+  //----------------------------------------------------------------------------
+  __attribute__((target("avx2")))
+  inline void csa(__m256i &h, __m256i &l, const __m256i a, const __m256i b, const __m256i c) {
+    const __m256i u = _mm256_xor_si256(a, b);
+    h = _mm256_or_si256(_mm256_and_si256(a, b), _mm256_and_si256(u, c));
+    l = _mm256_xor_si256(u, c);
+  }
+
+  struct LoadOne {
+    const uint64_t *a;
+    __attribute__((target("avx2")))
+    __m256i operator()(const std::size_t w) const {
+      return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + w));
+    }
+  };
+
+  struct LoadAnd {
+    const uint64_t *a;
+    const uint64_t *b;
+    __attribute__((target("avx2")))
+    __m256i operator()(const std::size_t w) const {
+      return _mm256_and_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + w)),
+                              _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + w)));
+    }
+  };
+
+  //----------------------------------------------------------------------------
+  // AVX2 Harley-Seal popcount. Sixteen vectors are reduced through a tree of
+  // carry-save adders so only one vector popcount is needed per block.
+  // Returns the count of the first (n / 64) * 64 words and sets 'done' to the
+  // number of words consumed.
+  //----------------------------------------------------------------------------
+  template <typename Load>
+  __attribute__((target("avx2")))
+  uint64_t harley_seal_avx2(const Load &load, const std::size_t n, std::size_t &done) {
+    __m256i total = _mm256_setzero_si256();
+    __m256i ones = _mm256_setzero_si256();
+    __m256i twos = _mm256_setzero_si256();
+    __m256i fours = _mm256_setzero_si256();
+    __m256i eights = _mm256_setzero_si256();
+    __m256i sixteens, twos_a, twos_b, fours_a, fours_b, eights_a, eights_b;
+
+    std::size_t w = 0;
+    for (; w + 64 <= n; w += 64) {
+      csa(twos_a, ones, ones, load(w), load(w + 4));
+      csa(twos_b, ones, ones, load(w + 8), load(w + 12));
+      csa(fours_a, twos, twos, twos_a, twos_b);
+      csa(twos_a, ones, ones, load(w + 16), load(w + 20));
+      csa(twos_b, ones, ones, load(w + 24), load(w + 28));
+      csa(fours_b, twos, twos, twos_a, twos_b);
+      csa(eights_a, fours, fours, fours_a, fours_b);
+      csa(twos_a, ones, ones, load(w + 32), load(w + 36));
+      csa(twos_b, ones, ones, load(w + 40), load(w + 44));
+      csa(fours_a, twos, twos, twos_a, twos_b);
+      csa(twos_a, ones, ones, load(w + 48), load(w + 52));
+      csa(twos_b, ones, ones, load(w + 56), load(w + 60));
+      csa(fours_b, twos, twos, twos_a, twos_b);
+      csa(eights_b, fours, fours, fours_a, fours_b);
+      csa(sixteens, eights, eights, eights_a, eights_b);
+      total = _mm256_add_epi64(total, popcount_256(sixteens));
+    }
+
+    total = _mm256_slli_epi64(total, 4);
+    total = _mm256_add_epi64(total, _mm256_slli_epi64(popcount_256(eights), 3));
+    total = _mm256_add_epi64(total, _mm256_slli_epi64(popcount_256(fours), 2));
+    total = _mm256_add_epi64(total, _mm256_slli_epi64(popcount_256(twos), 1));
+    total = _mm256_add_epi64(total, popcount_256(ones));
+
+    done = w;
+    return static_cast<uint64_t>(_mm256_extract_epi64(total, 0)) +
+           static_cast<uint64_t>(_mm256_extract_epi64(total, 1)) +
+           static_cast<uint64_t>(_mm256_extract_epi64(total, 2)) +
+           static_cast<uint64_t>(_mm256_extract_epi64(total, 3));
+  }
+
+  __attribute__((target("avx2,popcnt")))
+  std::size_t count_avx2(const uint64_t *a, const std::size_t n) {
+    if (n < harley_seal_min_words) {
+      return count_popcnt(a, n);
+    }
+    std::size_t done = 0;
+    const LoadOne load = {a};
+    const uint64_t total = harley_seal_avx2(load, n, done);
+    return total + count_popcnt(a + done, n - done);
+  }
+
+  __attribute__((target("avx2,popcnt")))
+  std::size_t count_and_avx2(const uint64_t *a, const uint64_t *b, const std::size_t n) {
+    if (n < harley_seal_min_words) {
+      return count_and_popcnt(a, b, n);
+    }
+    std::size_t done = 0;
+    const LoadAnd load = {a, b};
+    const uint64_t total = harley_seal_avx2(load, n, done);
+    return total + count_and_popcnt(a + done, b + done, n - done);
+  }
+#endif
+
+  //----------------------------------------------------------------------------
+  // Selects the kernels for the running CPU.
+  //----------------------------------------------------------------------------
+  struct Dispatch {
+    CountFn count;
+    CountAndFn count_and;
+
+    Dispatch() : count(count_generic), count_and(count_and_generic) {
+#ifdef MRCLEAN_X86
+      __builtin_cpu_init();
+      if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt")) {
+        count = count_avx2;
+        count_and = count_and_avx2;
+      } else if (__builtin_cpu_supports("popcnt")) {
+        count = count_popcnt;
+        count_and = count_and_popcnt;
+      }
+#endif
+    }
+  };
+
+  const Dispatch &get_dispatch() {
+    static const Dispatch dispatch;
+    return dispatch;
+  }
+}
+
+//------------------------------------------------------------------------------
+// Returns the number of set bits in a[0..num_words).
+//------------------------------------------------------------------------------
+std::size_t popcount_kernels::count(const uint64_t *a, const std::size_t num_words) {
+  return get_dispatch().count(a, num_words);
+}
+
+//------------------------------------------------------------------------------
+// Returns the number of set bits in (a & b)[0..num_words).
+//------------------------------------------------------------------------------
+std::size_t popcount_kernels::count_and(const uint64_t *a,
+                                        const uint64_t *b,
+                                        const std::size_t num_words) {
+  return get_dispatch().count_and(a, b, num_words);
+}
+
+//------------------------------------------------------------------------------
+// Returns the number of set bits in (row_i & col_mask), summed over all rows i
+// selected by 'row_mask'.
+//------------------------------------------------------------------------------
+std::size_t popcount_kernels::count_and_rows(const uint64_t *rows,
+                                             const std::size_t row_stride,
+                                             const std::size_t num_rows,
+                                             const uint64_t *row_mask,
+                                             const uint64_t *col_mask,
+                                             const std::size_t num_words) {
+  const CountAndFn count_and_fn = get_dispatch().count_and;
+  std::size_t total = 0;
+
+  for (std::size_t w = 0; (w << 6) < num_rows; ++w) {
+    uint64_t bits = row_mask[w];
+    while (bits) {
+      const std::size_t i = (w << 6) + __builtin_ctzll(bits);
+      total += count_and_fn(rows + i * row_stride, col_mask, num_words);
+      bits &= bits - 1;
+    }
+  }
+  return total;
+}
+
+//------------------------------------------------------------------------------
+// Bitsliced vertical counter. For every word column the state holds the
+// carry-save partial sums 'ones', 'twos' and 'fours' plus 'num_planes'
+// bit-planes of a binary counter of weight 8. Eight rows at a time are reduced
+// through carry-save adders and the resulting 'eights' word is rippled into
+// the planes, so each row costs a few logic operations per 64 columns. The
+// planes are flushed to 'counts' before they can overflow.
+//------------------------------------------------------------------------------
+void popcount_kernels::count_columns(const uint64_t *rows,
+                                     const std::size_t row_stride,
+                                     const std::size_t num_rows,
+                                     const uint64_t *row_mask,
+                                     const std::size_t num_cols,
+                                     std::size_t *counts) {
+  const std::size_t num_planes = 16;
+  const std::size_t state_size = num_planes + 3;
+  const std::size_t max_groups = (std::size_t(1) << num_planes) - 1;
+  const std::size_t num_words = (num_cols + 63) >> 6;
+
+  std::vector<uint64_t> state(num_words * state_size, 0);
+  const std::vector<uint64_t> zero_row(num_words, 0);
+  std::fill(counts, counts + num_cols, std::size_t(0));
+
+  // Adds the weight-8 planes of every word column to 'counts' and clears them
+  auto flush_planes = [&]() {
+    for (std::size_t w = 0; w < num_words; ++w) {
+      uint64_t *planes = &state[w * state_size + 3];
+      for (std::size_t k = 0; k < num_planes; ++k) {
+        uint64_t bits = planes[k];
+        while (bits) {
+          counts[(w << 6) + __builtin_ctzll(bits)] += std::size_t(8) << k;
+          bits &= bits - 1;
+        }
+        planes[k] = 0;
+      }
+    }
+  };
+
+  const uint64_t *group[8];
+  std::size_t group_size = 0;
+  std::size_t num_groups = 0;
+
+  for (std::size_t i = 0; i <= num_rows; ++i) {
+    if (i < num_rows) {
+      if ((row_mask[i >> 6] >> (i & 63)) & 1) {
+        group[group_size++] = rows + i * row_stride;
+      }
+      if (group_size < 8) {
+        continue;
+      }
+    } else if (group_size == 0) {
+      break;
+    }
+
+    // Pad a final partial group with all-zero rows
+    for (std::size_t r = group_size; r < 8; ++r) {
+      group[r] = zero_row.data();
+    }
+
+    for (std::size_t w = 0; w < num_words; ++w) {
+      uint64_t *st = &state[w * state_size];
+      uint64_t ones = st[0], twos = st[1], fours = st[2];
+      uint64_t twos_a, twos_b, fours_a, fours_b, eights, u;
+
+      u = ones ^ group[0][w]; twos_a = (ones & group[0][w]) | (u & group[1][w]); ones = u ^ group[1][w];
+      u = ones ^ group[2][w]; twos_b = (ones & group[2][w]) | (u & group[3][w]); ones = u ^ group[3][w];
+      u = twos ^ twos_a; fours_a = (twos & twos_a) | (u & twos_b); twos = u ^ twos_b;
+      u = ones ^ group[4][w]; twos_a = (ones & group[4][w]) | (u & group[5][w]); ones = u ^ group[5][w];
+      u = ones ^ group[6][w]; twos_b = (ones & group[6][w]) | (u & group[7][w]); ones = u ^ group[7][w];
+      u = twos ^ twos_a; fours_b = (twos & twos_a) | (u & twos_b); twos = u ^ twos_b;
+      u = fours ^ fours_a; eights = (fours & fours_a) | (u & fours_b); fours = u ^ fours_b;
+
+      st[0] = ones;
+      st[1] = twos;
+      st[2] = fours;
+
+      // Ripple the weight-8 carries into the bit-planes
+      uint64_t *planes = st + 3;
+      for (std::size_t k = 0; eights != 0; ++k) {
+        const uint64_t carry = planes[k] & eights;
+        planes[k] ^= eights;
+        eights = carry;
+      }
+    }
+
+    group_size = 0;
+    if (++num_groups == max_groups) {
+      flush_planes();
+      num_groups = 0;
+    }
+  }
+
+  flush_planes();
+
+  // Add the low-order partial sums
+  for (std::size_t j = 0; j < num_cols; ++j) {
+    const uint64_t *st = &state[(j >> 6) * state_size];
+    const std::size_t b = j & 63;
+    counts[j] += ((st[0] >> b) & 1) + 2 * ((st[1] >> b) & 1) + 4 * ((st[2] >> b) & 1);
+  }
+}
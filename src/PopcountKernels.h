@@ -0,0 +1,40 @@
+#ifndef POPCOUNT_KERNELS_H
+#define POPCOUNT_KERNELS_H
+
+#include <cstdint>
+#include <cstddef>
+
+//------------------------------------------------------------------------------
+// Word-parallel population count kernels used to count valid elements. The
+// implementation is picked once at runtime: AVX2 Harley-Seal for long inputs
+// when the CPU supports it, otherwise hardware POPCNT, otherwise a portable
+// fallback.
+//------------------------------------------------------------------------------
+namespace popcount_kernels {
+  // Number of set bits in a[0..num_words)
+  std::size_t count(const uint64_t *a, const std::size_t num_words);
+
+  // Number of set bits in (a & b)[0..num_words)
+  std::size_t count_and(const uint64_t *a, const uint64_t *b, const std::size_t num_words);
+
+  // Sum of count_and(row_i, col_mask) over every row i whose bit is set in
+  // 'row_mask'. Row i starts at rows + i * row_stride.
+  std::size_t count_and_rows(const uint64_t *rows,
+                             const std::size_t row_stride,
+                             const std::size_t num_rows,
+                             const uint64_t *row_mask,
+                             const uint64_t *col_mask,
+                             const std::size_t num_words);
+
+  // Number of set bits in each of the first 'num_cols' columns, counted over
+  // the rows selected by 'row_mask'. Consumes row-major words and accumulates
+  // 64 columns per word in bitsliced counters. Writes counts[0..num_cols).
+  void count_columns(const uint64_t *rows,
+                     const std::size_t row_stride,
+                     const std::size_t num_rows,
+                     const uint64_t *row_mask,
+                     const std::size_t num_cols,
+                     std::size_t *counts);
+}
+
+#endif
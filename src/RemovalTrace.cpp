@@ -0,0 +1,204 @@
+#include "RemovalTrace.h"
+#include <cstdio>
+
+namespace {
+  const uint64_t trace_magic = 0x314543415254524dULL; // "MRTRACE1"
+  const uint64_t trace_version = 1;
+
+  struct TraceHeader {
+    uint64_t magic;
+    uint64_t version;
+    uint64_t num_rows;
+    uint64_t num_cols;
+    uint64_t num_steps;
+    uint64_t num_removed;
+  };
+}
+
+//------------------------------------------------------------------------------
+// Constructor. Creates an empty trace, to be filled by load().
+//------------------------------------------------------------------------------
+RemovalTrace::RemovalTrace() : num_rows(0),
+                               num_cols(0),
+                               num_logged(0) {}
+
+//------------------------------------------------------------------------------
+// Constructor. Starts a trace of a 'num_rows' x 'num_cols' matrix with
+// 'num_valid' valid elements. Space for the longest trace is reserved so that
+// logging does not allocate during solve(). The trace has no user-declared
+// destructor, so moving it keeps that space.
+//------------------------------------------------------------------------------
+RemovalTrace::RemovalTrace(const std::size_t _num_rows,
+                           const std::size_t _num_cols,
+                           const std::size_t num_valid) : num_rows(_num_rows),
+                                                          num_cols(_num_cols),
+                                                          num_logged(0) {
+  // Each row and column is removed at most once, in at most one step each
+  steps.reserve(num_rows + num_cols + 1);
+  removed.reserve(num_rows + num_cols);
+
+  Step full = {0, 0, num_rows, num_cols, num_valid};
+  steps.push_back(full);
+}
+
+//------------------------------------------------------------------------------
+// Closes the step made of the indices added since the previous step.
+//------------------------------------------------------------------------------
+void RemovalTrace::end_step(const bool is_row,
+                            const std::size_t num_rows_kept,
+                            const std::size_t num_cols_kept,
+                            const std::size_t num_valid) {
+  Step step = {is_row, removed.size() - num_logged, num_rows_kept, num_cols_kept, num_valid};
+  steps.push_back(step);
+  num_logged = removed.size();
+}
+
+//------------------------------------------------------------------------------
+// Returns the number of rows of the traced matrix.
+//------------------------------------------------------------------------------
+std::size_t RemovalTrace::get_num_rows() const {
+  return num_rows;
+}
+
+//------------------------------------------------------------------------------
+// Returns the number of columns of the traced matrix.
+//------------------------------------------------------------------------------
+std::size_t RemovalTrace::get_num_cols() const {
+  return num_cols;
+}
+
+//------------------------------------------------------------------------------
+// Returns the number of steps, not counting step 0.
+//------------------------------------------------------------------------------
+std::size_t RemovalTrace::get_num_steps() const {
+  return steps.empty() ? 0 : steps.size() - 1;
+}
+
+//------------------------------------------------------------------------------
+// Returns step 'k', 0 being the full matrix.
+//------------------------------------------------------------------------------
+const RemovalTrace::Step &RemovalTrace::get_step(const std::size_t k) const {
+  return steps[k];
+}
+
+//------------------------------------------------------------------------------
+// Sets 'keep_row' and 'keep_col' to the rows and columns kept after the first
+// 'num_steps' steps, by applying those steps' removals to the full matrix.
+//------------------------------------------------------------------------------
+void RemovalTrace::replay(const std::size_t num_steps,
+                          std::vector<bool> &keep_row,
+                          std::vector<bool> &keep_col) const {
+  keep_row.assign(num_rows, true);
+  keep_col.assign(num_cols, true);
+
+  std::size_t pos = 0;
+  for (std::size_t k = 1; k <= num_steps && k < steps.size(); ++k) {
+    std::vector<bool> &keep = steps[k].is_row ? keep_row : keep_col;
+    for (std::size_t n = 0; n < steps[k].num_removed; ++n) {
+      keep[removed[pos++]] = false;
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Returns the steps on the frontier of kept rows, kept columns and percent of
+// missing data. Rows and columns are only removed, so a step is dominated by
+// every earlier one unless it has less missing data than all of them: the
+// frontier is step 0 and each step with a new lowest percent missing.
+//------------------------------------------------------------------------------
+std::vector<std::size_t> RemovalTrace::get_frontier() const {
+  std::vector<std::size_t> frontier;
+
+  // Percents are compared exactly as missing_k * size_f < missing_f * size_k
+  uint64_t best_missing = 0;
+  uint64_t best_size = 0;
+  for (std::size_t k = 0; k < steps.size(); ++k) {
+    const uint64_t size = steps[k].num_rows_kept * steps[k].num_cols_kept;
+    const uint64_t missing = size - steps[k].num_valid;
+    if (frontier.empty() ||
+        (size > 0 && (best_size == 0 ||
+                      static_cast<unsigned __int128>(missing) * best_size <
+                      static_cast<unsigned __int128>(best_missing) * size))) {
+      frontier.push_back(k);
+      best_missing = missing;
+      best_size = size;
+    }
+  }
+
+  return frontier;
+}
+
+//------------------------------------------------------------------------------
+// Writes the trace to 'file_name'. Returns false on failure.
+//------------------------------------------------------------------------------
+bool RemovalTrace::save(const std::string &file_name) const {
+  FILE *output = fopen(file_name.c_str(), "wb");
+  if (output == nullptr) {
+    return false;
+  }
+
+  TraceHeader header = {trace_magic, trace_version, num_rows, num_cols, steps.size(), removed.size()};
+  bool ok = fwrite(&header, sizeof(header), 1, output) == 1;
+  ok = ok && fwrite(steps.data(), sizeof(Step), steps.size(), output) == steps.size();
+  ok = ok && fwrite(removed.data(), sizeof(uint64_t), removed.size(), output) == removed.size();
+  ok = (fclose(output) == 0) && ok;
+  return ok;
+}
+
+//------------------------------------------------------------------------------
+// Reads a trace written by save(). Returns false if the file cannot be read
+// or is not a consistent trace.
+//------------------------------------------------------------------------------
+bool RemovalTrace::load(const std::string &file_name) {
+  FILE *input = fopen(file_name.c_str(), "rb");
+  if (input == nullptr) {
+    return false;
+  }
+
+  TraceHeader header;
+  bool ok = fread(&header, sizeof(header), 1, input) == 1 &&
+            header.magic == trace_magic &&
+            header.version == trace_version &&
+            header.num_steps > 0 &&
+            header.num_steps <= header.num_rows + header.num_cols + 1 &&
+            header.num_removed <= header.num_rows + header.num_cols;
+  if (ok) {
+    steps.resize(header.num_steps);
+    removed.resize(header.num_removed);
+    ok = fread(steps.data(), sizeof(Step), steps.size(), input) == steps.size() &&
+         fread(removed.data(), sizeof(uint64_t), removed.size(), input) == removed.size() &&
+         fgetc(input) == EOF;
+  }
+  fclose(input);
+  if (!ok) {
+    return false;
+  }
+
+  // Check that the counts are consistent and replaying the steps stays within
+  // the matrix
+  for (const auto &step : steps) {
+    if (step.num_rows_kept > header.num_rows ||
+        step.num_cols_kept > header.num_cols ||
+        step.num_valid > step.num_rows_kept * step.num_cols_kept) {
+      return false;
+    }
+  }
+  uint64_t num_removed = 0;
+  for (std::size_t k = 1; k < steps.size(); ++k) {
+    const uint64_t bound = steps[k].is_row ? header.num_rows : header.num_cols;
+    for (uint64_t n = 0; n < steps[k].num_removed; ++n) {
+      if (num_removed >= removed.size() || removed[num_removed] >= bound) {
+        return false;
+      }
+      ++num_removed;
+    }
+  }
+  if (num_removed != removed.size()) {
+    return false;
+  }
+
+  num_rows = header.num_rows;
+  num_cols = header.num_cols;
+  num_logged = removed.size();
+  return true;
+}
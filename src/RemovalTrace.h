@@ -0,0 +1,62 @@
+#ifndef REMOVAL_TRACE_H
+#define REMOVAL_TRACE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//------------------------------------------------------------------------------
+// Log of the removals made by a greedy solver. Each step holds whether rows
+// or columns were removed, how many, and the number of rows, columns and
+// valid elements kept after it. The removed indices of all steps are stored
+// one after the other. Step 0 is the full matrix.
+//
+// The trace file is a fixed header followed by the steps and the removed
+// indices, all as 64-bit words.
+//------------------------------------------------------------------------------
+class RemovalTrace {
+public:
+  struct Step {
+    uint64_t is_row;
+    uint64_t num_removed;
+    uint64_t num_rows_kept;
+    uint64_t num_cols_kept;
+    uint64_t num_valid;
+  };
+
+private:
+  uint64_t num_rows;
+  uint64_t num_cols;
+  std::vector<Step> steps;
+  std::vector<uint64_t> removed;
+  std::size_t num_logged;
+
+public:
+  RemovalTrace();
+  RemovalTrace(const std::size_t _num_rows,
+               const std::size_t _num_cols,
+               const std::size_t num_valid);
+
+  void add_removed(const std::size_t idx) {
+    removed.push_back(idx);
+  }
+  void end_step(const bool is_row,
+                const std::size_t num_rows_kept,
+                const std::size_t num_cols_kept,
+                const std::size_t num_valid);
+
+  std::size_t get_num_rows() const;
+  std::size_t get_num_cols() const;
+  std::size_t get_num_steps() const;
+  const Step &get_step(const std::size_t k) const;
+
+  void replay(const std::size_t num_steps,
+              std::vector<bool> &keep_row,
+              std::vector<bool> &keep_col) const;
+  std::vector<std::size_t> get_frontier() const;
+
+  bool save(const std::string &file_name) const;
+  bool load(const std::string &file_name);
+};
+
+#endif
@@ -0,0 +1,197 @@
+#include "SelectionQueue.h"
+#include <assert.h>
+
+namespace {
+  const std::size_t not_in_heap = static_cast<std::size_t>(-1);
+}
+
+//------------------------------------------------------------------------------
+// Constructor. Creates an empty queue.
+//------------------------------------------------------------------------------
+SelectionQueue::SelectionQueue() : bucket_count(1, 0),
+                                   threshold(0),
+                                   num_violators(0) {}
+
+//------------------------------------------------------------------------------
+// Constructor. All items start in the queue with a threshold of zero, so no
+// item is a violator until set_threshold() is called. Ties between equal keys
+// follow '_rank' when it is not empty.
+//------------------------------------------------------------------------------
+SelectionQueue::SelectionQueue(const std::vector<std::size_t> &_key,
+                               const std::size_t max_key,
+                               const std::vector<std::size_t> &_rank) : heap(_key.size()),
+                                                                        pos(_key.size()),
+                                                                        key(_key),
+                                                                        rank(_rank),
+                                                                        bucket_count(max_key + 1, 0),
+                                                                        threshold(0),
+                                                                        num_violators(0) {
+  assert(rank.empty() || rank.size() == key.size());
+  for (std::size_t i = 0; i < key.size(); ++i) {
+    assert(key[i] <= max_key);
+    heap[i] = i;
+    pos[i] = i;
+    ++bucket_count[key[i]];
+  }
+
+  for (std::size_t p = heap.size() / 2; p-- > 0;) {
+    sift_down(p);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Destructor.
+//------------------------------------------------------------------------------
+SelectionQueue::~SelectionQueue() {}
+
+//------------------------------------------------------------------------------
+// Heap order: smaller key first, ties broken by the smaller index or rank.
+//------------------------------------------------------------------------------
+bool SelectionQueue::less(const std::size_t a, const std::size_t b) const {
+  return key[a] < key[b] || (key[a] == key[b] && (rank.empty() ? a < b : rank[a] < rank[b]));
+}
+
+void SelectionQueue::sift_up(std::size_t p) {
+  const std::size_t item = heap[p];
+  while (p > 0) {
+    const std::size_t parent = (p - 1) / 2;
+    if (!less(item, heap[parent])) {
+      break;
+    }
+    heap[p] = heap[parent];
+    pos[heap[p]] = p;
+    p = parent;
+  }
+  heap[p] = item;
+  pos[item] = p;
+}
+
+void SelectionQueue::sift_down(std::size_t p) {
+  const std::size_t item = heap[p];
+  const std::size_t n = heap.size();
+  while (true) {
+    std::size_t child = 2 * p + 1;
+    if (child >= n) {
+      break;
+    }
+    if (child + 1 < n && less(heap[child + 1], heap[child])) {
+      ++child;
+    }
+    if (!less(heap[child], item)) {
+      break;
+    }
+    heap[p] = heap[child];
+    pos[heap[p]] = p;
+    p = child;
+  }
+  heap[p] = item;
+  pos[item] = p;
+}
+
+//------------------------------------------------------------------------------
+// Returns true if no items remain.
+//------------------------------------------------------------------------------
+bool SelectionQueue::empty() const {
+  return heap.empty();
+}
+
+//------------------------------------------------------------------------------
+// Returns true if 'idx' has not been removed.
+//------------------------------------------------------------------------------
+bool SelectionQueue::contains(const std::size_t idx) const {
+  return pos[idx] != not_in_heap;
+}
+
+//------------------------------------------------------------------------------
+// Returns the item with the smallest key.
+//------------------------------------------------------------------------------
+std::size_t SelectionQueue::top() const {
+  assert(!heap.empty());
+  return heap[0];
+}
+
+//------------------------------------------------------------------------------
+// Returns the smallest key.
+//------------------------------------------------------------------------------
+std::size_t SelectionQueue::top_key() const {
+  assert(!heap.empty());
+  return key[heap[0]];
+}
+
+//------------------------------------------------------------------------------
+// Returns the key of 'idx'.
+//------------------------------------------------------------------------------
+std::size_t SelectionQueue::get_key(const std::size_t idx) const {
+  return key[idx];
+}
+
+//------------------------------------------------------------------------------
+// Returns the number of items whose key is below the threshold.
+//------------------------------------------------------------------------------
+std::size_t SelectionQueue::get_num_violators() const {
+  return num_violators;
+}
+
+//------------------------------------------------------------------------------
+// Lowers the key of 'idx' by 'amount'.
+//------------------------------------------------------------------------------
+void SelectionQueue::decrease_key(const std::size_t idx, const std::size_t amount) {
+  assert(contains(idx));
+  assert(key[idx] >= amount);
+
+  if (amount == 0) {
+    return;
+  }
+
+  const std::size_t old_key = key[idx];
+  const std::size_t new_key = old_key - amount;
+  --bucket_count[old_key];
+  ++bucket_count[new_key];
+  if (old_key >= threshold && new_key < threshold) {
+    ++num_violators;
+  }
+
+  key[idx] = new_key;
+  sift_up(pos[idx]);
+}
+
+//------------------------------------------------------------------------------
+// Removes 'idx' from the queue.
+//------------------------------------------------------------------------------
+void SelectionQueue::remove(const std::size_t idx) {
+  assert(contains(idx));
+
+  --bucket_count[key[idx]];
+  if (key[idx] < threshold) {
+    --num_violators;
+  }
+
+  const std::size_t p = pos[idx];
+  const std::size_t last = heap.back();
+  heap.pop_back();
+  pos[idx] = not_in_heap;
+
+  if (last != idx) {
+    heap[p] = last;
+    pos[last] = p;
+    sift_up(p);
+    sift_down(pos[last]);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Moves the violation threshold. The violator count is adjusted by the bucket
+// counts between the old and new threshold, so monotone threshold changes
+// cost O(1) amortized.
+//------------------------------------------------------------------------------
+void SelectionQueue::set_threshold(const std::size_t _threshold) {
+  const std::size_t max_key = bucket_count.size() - 1;
+
+  for (std::size_t k = _threshold; k < threshold && k <= max_key; ++k) {
+    num_violators -= bucket_count[k];
+  }
+  for (std::size_t k = threshold; k < _threshold && k <= max_key; ++k) {
+    num_violators += bucket_count[k];
+  }
+  threshold = _threshold;
+}
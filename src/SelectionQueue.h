@@ -0,0 +1,48 @@
+#ifndef SELECTION_QUEUE_H
+#define SELECTION_QUEUE_H
+
+#include <cstddef>
+#include <vector>
+
+//------------------------------------------------------------------------------
+// Indexed binary min-heap over items 0..n-1 keyed by their number of valid
+// elements. The top is the item with the smallest key, ties going to the
+// smallest index, or to the smallest rank when ranks are given. Keys only
+// decrease and items can be removed. Items whose key is below a movable
+// threshold are counted as violators, which is kept up to date in O(1)
+// amortized time through per-key bucket counts.
+//------------------------------------------------------------------------------
+class SelectionQueue {
+private:
+  std::vector<std::size_t> heap;
+  std::vector<std::size_t> pos;
+  std::vector<std::size_t> key;
+  std::vector<std::size_t> rank;
+  std::vector<std::size_t> bucket_count;
+  std::size_t threshold;
+  std::size_t num_violators;
+
+  bool less(const std::size_t a, const std::size_t b) const;
+  void sift_up(std::size_t p);
+  void sift_down(std::size_t p);
+
+public:
+  SelectionQueue();
+  SelectionQueue(const std::vector<std::size_t> &_key,
+                 const std::size_t max_key,
+                 const std::vector<std::size_t> &_rank = std::vector<std::size_t>());
+  ~SelectionQueue();
+
+  bool empty() const;
+  bool contains(const std::size_t idx) const;
+  std::size_t top() const;
+  std::size_t top_key() const;
+  std::size_t get_key(const std::size_t idx) const;
+  std::size_t get_num_violators() const;
+
+  void decrease_key(const std::size_t idx, const std::size_t amount = 1);
+  void remove(const std::size_t idx);
+  void set_threshold(const std::size_t _threshold);
+};
+
+#endif
@@ -0,0 +1,134 @@
+#include "SolverPortfolio.h"
+#include <assert.h>
+#include <thread>
+#include "Timer.h"
+
+//------------------------------------------------------------------------------
+// Constructor.
+//------------------------------------------------------------------------------
+SolverPortfolio::SolverPortfolio(const BinContainer &_data) : data(&_data),
+                                                              incumbent(0),
+                                                              best_solver(0) {}
+
+//------------------------------------------------------------------------------
+// Destructor.
+//------------------------------------------------------------------------------
+SolverPortfolio::~SolverPortfolio() {}
+
+//------------------------------------------------------------------------------
+// Adds 'solver', reported as 'name'. Solvers are started in the order they are
+// added.
+//------------------------------------------------------------------------------
+void SolverPortfolio::add_solver(const std::string &name, const Solver &solver) {
+  solvers.push_back(solver);
+  Run run = {name, 0, false, 0, 0, 0};
+  runs.push_back(run);
+}
+
+//------------------------------------------------------------------------------
+// Runs every solver. When 'concurrent', the first solver runs on the calling
+// thread, so that it can use the whole thread pool, while the others run one
+// after the other on a helper thread. Otherwise they all run one after the
+// other on the calling thread.
+//------------------------------------------------------------------------------
+void SolverPortfolio::solve(const bool concurrent) {
+  best_solver = solvers.size();
+  incumbent = 0;
+
+  if (!concurrent || solvers.size() < 2) {
+    for (std::size_t k = 0; k < solvers.size(); ++k) {
+      run_solver(k);
+    }
+    return;
+  }
+
+  std::thread helper([this]() {
+    for (std::size_t k = 1; k < solvers.size(); ++k) {
+      run_solver(k);
+    }
+  });
+  run_solver(0);
+  helper.join();
+}
+
+//------------------------------------------------------------------------------
+// Runs solver 'k' and keeps its solution if it has more valid elements than
+// the best so far, or as many and the solver was added earlier.
+//------------------------------------------------------------------------------
+void SolverPortfolio::run_solver(const std::size_t k) {
+  std::vector<bool> rows_to_keep;
+  std::vector<bool> cols_to_keep;
+
+  Timer solve_timer(true);
+  const bool solved = solvers[k](&incumbent, rows_to_keep, cols_to_keep);
+  solve_timer.stop();
+
+  Run &run = runs[k];
+  run.time = solve_timer.elapsed_wall_time();
+  run.solved = solved;
+  if (!solved) {
+    return;
+  }
+  run.num_valid = data->get_num_valid_data_kept(rows_to_keep, cols_to_keep);
+  for (auto keep : rows_to_keep) {
+    run.num_rows_kept += keep;
+  }
+  for (auto keep : cols_to_keep) {
+    run.num_cols_kept += keep;
+  }
+
+  std::lock_guard<std::mutex> lock(best_mutex);
+  if (best_solver == solvers.size() ||
+      run.num_valid > incumbent ||
+      (run.num_valid == incumbent && k < best_solver)) {
+    best_solver = k;
+    best_rows.swap(rows_to_keep);
+    best_cols.swap(cols_to_keep);
+    incumbent = run.num_valid;
+  }
+}
+
+//------------------------------------------------------------------------------
+// Returns true if some solver found a solution.
+//------------------------------------------------------------------------------
+bool SolverPortfolio::is_solved() const {
+  return best_solver < solvers.size();
+}
+
+//------------------------------------------------------------------------------
+// Returns a boolean vector where elements are 'true' if the corresponding row
+// is kept in the best solution.
+//------------------------------------------------------------------------------
+std::vector<bool> SolverPortfolio::get_rows_to_keep() const {
+  return best_rows;
+}
+
+//------------------------------------------------------------------------------
+// Returns a boolean vector where elements are 'true' if the corresponding
+// column is kept in the best solution.
+//------------------------------------------------------------------------------
+std::vector<bool> SolverPortfolio::get_cols_to_keep() const {
+  return best_cols;
+}
+
+//------------------------------------------------------------------------------
+// Returns the number of valid elements in the best solution.
+//------------------------------------------------------------------------------
+std::size_t SolverPortfolio::get_num_valid_kept() const {
+  return incumbent;
+}
+
+//------------------------------------------------------------------------------
+// Returns the name of the solver that found the best solution.
+//------------------------------------------------------------------------------
+const std::string &SolverPortfolio::get_best_solver() const {
+  assert(is_solved());
+  return runs[best_solver].name;
+}
+
+//------------------------------------------------------------------------------
+// Returns the outcome of every solver, in the order they were added.
+//------------------------------------------------------------------------------
+const std::vector<SolverPortfolio::Run> &SolverPortfolio::get_runs() const {
+  return runs;
+}
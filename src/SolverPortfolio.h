@@ -0,0 +1,69 @@
+#ifndef SOLVER_PORTFOLIO_H
+#define SOLVER_PORTFOLIO_H
+
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "BinContainer.h"
+
+//------------------------------------------------------------------------------
+// Runs several solvers of the same problem concurrently and keeps the best
+// solution. Each solver is handed the number of valid elements of the best
+// solution found so far, which it reads as it goes to give up, or stop early,
+// once it cannot reach it. Every finished solver publishes its solution right
+// away, so the others can stop as soon as possible.
+//
+// Ties go to the solver added first. Solvers only give up when they cannot
+// even tie the best, so the solution kept does not depend on which solvers
+// finish first.
+//------------------------------------------------------------------------------
+class SolverPortfolio {
+public:
+  // Runs a solver that stops once it cannot reach '*incumbent'. Returns false
+  // if it gave up or found no solution, otherwise sets the rows and columns it
+  // keeps.
+  typedef std::function<bool(const std::atomic<std::size_t> *incumbent,
+                             std::vector<bool> &rows_to_keep,
+                             std::vector<bool> &cols_to_keep)> Solver;
+
+  // Outcome of one solver
+  struct Run {
+    std::string name;
+    double time;
+    bool solved;
+    std::size_t num_valid;
+    std::size_t num_rows_kept;
+    std::size_t num_cols_kept;
+  };
+
+private:
+  const BinContainer *data;
+  std::vector<Solver> solvers;
+  std::vector<Run> runs;
+
+  std::atomic<std::size_t> incumbent;
+  std::mutex best_mutex;
+  std::size_t best_solver;
+  std::vector<bool> best_rows;
+  std::vector<bool> best_cols;
+
+  void run_solver(const std::size_t k);
+
+public:
+  explicit SolverPortfolio(const BinContainer &_data);
+  ~SolverPortfolio();
+
+  void add_solver(const std::string &name, const Solver &solver);
+  void solve(const bool concurrent);
+
+  bool is_solved() const;
+  std::vector<bool> get_rows_to_keep() const;
+  std::vector<bool> get_cols_to_keep() const;
+  std::size_t get_num_valid_kept() const;
+  const std::string &get_best_solver() const;
+  const std::vector<Run> &get_runs() const;
+};
+
+#endif
@@ -0,0 +1,128 @@
+#include "ThreadPool.h"
+#include <algorithm>
+
+namespace {
+  thread_local bool in_pool_task = false;
+}
+
+//------------------------------------------------------------------------------
+// Constructor. Starts 'num_threads' - 1 workers; the thread calling
+// parallel_for() is the remaining one.
+//------------------------------------------------------------------------------
+ThreadPool::ThreadPool(const std::size_t num_threads) : task(nullptr),
+                                                        task_size(0),
+                                                        task_chunks(0),
+                                                        next_chunk(0),
+                                                        num_busy(0),
+                                                        generation(0),
+                                                        stopping(false) {
+  for (std::size_t t = 1; t < num_threads; ++t) {
+    workers.emplace_back(&ThreadPool::worker_loop, this);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Destructor. Stops and joins the workers.
+//------------------------------------------------------------------------------
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+  work_ready.notify_all();
+  for (auto &w : workers) {
+    w.join();
+  }
+}
+
+//------------------------------------------------------------------------------
+// Returns the number of threads that work on a parallel_for(), including the
+// calling thread.
+//------------------------------------------------------------------------------
+std::size_t ThreadPool::get_num_threads() const {
+  return workers.size() + 1;
+}
+
+//------------------------------------------------------------------------------
+// Returns the number of chunks parallel_for() splits 'n' items into. Every
+// chunk holds at least 'min_chunk' items, except when n < min_chunk.
+//------------------------------------------------------------------------------
+std::size_t ThreadPool::get_num_chunks(const std::size_t n, const std::size_t min_chunk) const {
+  if (n == 0) {
+    return 0;
+  }
+  return std::max<std::size_t>(1, std::min(get_num_threads(), n / std::max<std::size_t>(1, min_chunk)));
+}
+
+//------------------------------------------------------------------------------
+// Calls fn(chunk, begin, end) for every chunk of [0, n) and returns once all
+// chunks are done. Chunk k covers [k * n / c, (k + 1) * n / c), where c is
+// get_num_chunks(n, min_chunk).
+//------------------------------------------------------------------------------
+void ThreadPool::parallel_for(const std::size_t n,
+                              const std::size_t min_chunk,
+                              const ChunkFunction &fn) {
+  const std::size_t num_chunks = get_num_chunks(n, min_chunk);
+
+  if (num_chunks <= 1 || workers.empty() || in_pool_task) {
+    for (std::size_t k = 0; k < num_chunks; ++k) {
+      fn(k, k * n / num_chunks, (k + 1) * n / num_chunks);
+    }
+    return;
+  }
+
+  std::lock_guard<std::mutex> submit_lock(submit_mutex);
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    task = &fn;
+    task_size = n;
+    task_chunks = num_chunks;
+    next_chunk = 0;
+    num_busy = workers.size();
+    ++generation;
+  }
+  work_ready.notify_all();
+
+  run_chunks();
+
+  std::unique_lock<std::mutex> lock(mutex);
+  work_done.wait(lock, [this]() { return num_busy == 0; });
+  task = nullptr;
+}
+
+//------------------------------------------------------------------------------
+// Claims and runs chunks of the current task until none are left.
+//------------------------------------------------------------------------------
+void ThreadPool::run_chunks() {
+  in_pool_task = true;
+  std::size_t k;
+  while ((k = next_chunk++) < task_chunks) {
+    (*task)(k, k * task_size / task_chunks, (k + 1) * task_size / task_chunks);
+  }
+  in_pool_task = false;
+}
+
+//------------------------------------------------------------------------------
+// Waits for a new task, helps run it and reports back.
+//------------------------------------------------------------------------------
+void ThreadPool::worker_loop() {
+  std::size_t seen = 0;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      work_ready.wait(lock, [&]() { return stopping || generation != seen; });
+      if (stopping) {
+        return;
+      }
+      seen = generation;
+    }
+
+    run_chunks();
+
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      --num_busy;
+    }
+    work_done.notify_one();
+  }
+}
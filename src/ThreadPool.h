@@ -0,0 +1,53 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//------------------------------------------------------------------------------
+// Persistent pool of worker threads. parallel_for() splits [0, n) into
+// contiguous chunks whose boundaries depend only on n, the minimum chunk size
+// and the number of threads, so per-chunk results can be combined in chunk
+// order to give the same answer on every run. The calling thread works on
+// chunks too. A parallel_for() issued from inside a running task is executed
+// serially by the calling thread.
+//------------------------------------------------------------------------------
+class ThreadPool {
+public:
+  typedef std::function<void(std::size_t, std::size_t, std::size_t)> ChunkFunction;
+
+private:
+  std::vector<std::thread> workers;
+  std::mutex mutex;
+  std::condition_variable work_ready;
+  std::condition_variable work_done;
+  std::mutex submit_mutex;
+
+  const ChunkFunction *task;
+  std::size_t task_size;
+  std::size_t task_chunks;
+  std::atomic<std::size_t> next_chunk;
+  std::size_t num_busy;
+  std::size_t generation;
+  bool stopping;
+
+  void worker_loop();
+  void run_chunks();
+
+public:
+  explicit ThreadPool(const std::size_t num_threads);
+  ~ThreadPool();
+
+  std::size_t get_num_threads() const;
+  std::size_t get_num_chunks(const std::size_t n, const std::size_t min_chunk) const;
+  void parallel_for(const std::size_t n,
+                    const std::size_t min_chunk,
+                    const ChunkFunction &fn);
+};
+
+#endif
@@ -1,3 +1,10 @@
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <set>
 #include <string>
 #include <vector>
 #include <stdexcept>
@@ -10,6 +17,75 @@
 #include "CleanSolution.h"
 #include "BinContainer.h"
 #include "AddRowGreedy.h"
+#include "AddColGreedy.h"
+#include "AddRowGammaGreedy.h"
+#include "MultiStartGreedy.h"
+#include "SolverPortfolio.h"
+#include "ThreadPool.h"
+#include "MrCleanUtils.h"
+
+std::vector<double> parse_max_missing(const std::string &arg);
+std::string format_max_missing(const double max_perc_missing);
+
+CleanSolution solve_portfolio(const BinContainer &data,
+                              GreedySolver &greedy_solver,
+                              const bool cancel_greedy,
+                              const std::size_t row_lb,
+                              const std::size_t col_lb,
+                              const std::string &trajectory_file,
+                              const bool concurrent,
+                              std::vector<SolverPortfolio::Run> &runs);
+
+CleanSolution solve_from_trajectory(const BinContainer &data,
+                                    const std::string &trajectory_file,
+                                    const std::size_t row_lb,
+                                    const std::size_t col_lb);
+
+void write_trajectory(const std::string &file_name,
+                      const AddRowGreedy &ar_greedy);
+
+void run_multi_start(const BinContainer &data,
+                     CleanSolution &sol,
+                     const double max_perc_missing,
+                     const std::size_t row_lb,
+                     const std::size_t col_lb,
+                     const uint64_t seed,
+                     const std::size_t num_starts,
+                     const double time_budget,
+                     ThreadPool *pool,
+                     std::vector<SolverPortfolio::Run> &runs);
+
+void write_trace(const GreedySolver &greedy_solver,
+                 const std::string &data_file,
+                 const std::string &out_path);
+
+void run_continuation(const BinContainer &data,
+                      const std::vector<double> &sweep,
+                      const std::size_t row_lb,
+                      const std::size_t col_lb,
+                      const std::string &data_file,
+                      const std::string &out_path,
+                      const double load_time,
+                      const bool compare_cold,
+                      const bool trace,
+                      const bool compress,
+                      const bool solver_summary,
+                      ThreadPool *pool);
+
+std::string get_partial_file(const std::string &data_file,
+                             const std::string &out_path,
+                             const double max_perc_missing);
+
+void write_solution(const BinContainer &data,
+                    CleanSolution &sol,
+                    const std::vector<SolverPortfolio::Run> &runs,
+                    const std::string &data_file,
+                    const std::string &out_path,
+                    const double max_perc_missing,
+                    const double time,
+                    const std::size_t num_write_threads,
+                    const bool compress,
+                    const bool solver_summary);
 
 void write_stats_to_file(const std::string &file_name,
                          const std::string &data_file,
@@ -19,38 +95,133 @@ void write_stats_to_file(const std::string &file_name,
                          const std::size_t num_rows_kept,
                          const std::size_t num_cols_kept);
 
+void write_solver_stats_to_file(const std::string &file_name,
+                                const std::string &data_file,
+                                const double max_perc_missing,
+                                const std::vector<SolverPortfolio::Run> &runs);
+
 int main(int argc, char *argv[]) {
-  if (!((argc == 7) || (argc == 9))) {
-    fprintf(stderr, "Usage: %s <data_file> <max_missing> <row_lb> <col_lb> <na_symbol> <output_path> (opt)<num_hr> (opt)<num_hc>\n", argv[0]);
+  // Separate options from positional arguments
+  std::size_t num_threads = 1;
+  char delim = '\t';
+  bool continuation = false;
+  bool compare_cold = false;
+  bool compress = false;
+  bool trajectory = false;
+  bool trace = false;
+  bool solver_summary = false;
+  std::size_t num_starts = 0;
+  uint64_t seed = 0;
+  double time_budget = 0;
+  std::string from_trajectory;
+  std::string cache_dir;
+  std::vector<std::string> args;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg(argv[i]);
+    if (arg == "--threads" && i + 1 < argc) {
+      num_threads = std::stoul(argv[++i]);
+    } else if (arg == "--delim" && i + 1 < argc) {
+      std::string name(argv[++i]);
+      if (name == "tab") {
+        delim = '\t';
+      } else if (name == "comma") {
+        delim = ',';
+      } else if (name == "space") {
+        delim = ' ';
+      } else {
+        fprintf(stderr, "ERROR - Unknown delimiter '%s' (expected tab, comma or space).\n", name.c_str());
+        exit(EXIT_FAILURE);
+      }
+    } else if (arg == "--cache" && i + 1 < argc) {
+      cache_dir = argv[++i];
+    } else if (arg == "--compress" && i + 1 < argc) {
+      std::string name(argv[++i]);
+      if (name == "gzip") {
+        compress = true;
+      } else if (name == "none") {
+        compress = false;
+      } else {
+        fprintf(stderr, "ERROR - Unknown compression '%s' (expected gzip or none).\n", name.c_str());
+        exit(EXIT_FAILURE);
+      }
+    } else if (arg == "--continuation") {
+      continuation = true;
+    } else if (arg == "--compare-cold") {
+      compare_cold = true;
+    } else if (arg == "--multi-start" && i + 1 < argc) {
+      num_starts = std::stoul(argv[++i]);
+    } else if (arg == "--seed" && i + 1 < argc) {
+      seed = std::stoull(argv[++i]);
+    } else if (arg == "--time-budget" && i + 1 < argc) {
+      time_budget = std::stod(argv[++i]);
+    } else if (arg == "--solver-summary") {
+      solver_summary = true;
+    } else if (arg == "--trace") {
+      trace = true;
+    } else if (arg == "--trajectory") {
+      trajectory = true;
+    } else if (arg == "--from-trajectory" && i + 1 < argc) {
+      from_trajectory = argv[++i];
+    } else {
+      args.push_back(arg);
+    }
+  }
+
+  if (!((args.size() == 6) || (args.size() == 8))) {
+    fprintf(stderr, "Usage: %s [--threads <n>] [--delim tab|comma|space] [--cache <dir>] [--compress gzip|none] [--continuation [--compare-cold]] [--multi-start <n> [--seed <n>] [--time-budget <s>]] [--trace] [--solver-summary] [--trajectory | --from-trajectory <file>] <data_file> <max_missing> <row_lb> <col_lb> <na_symbol> <output_path> (opt)<num_hr> (opt)<num_hc>\n", argv[0]);
     exit(EXIT_FAILURE);
   }
 
-  std::string data_file(argv[1])  ;
-  double max_perc_missing = std::stod(argv[2]);
-  std::size_t row_lb = std::stoul(argv[3]);
-  std::size_t col_lb = std::stoul(argv[4]);
-  std::string na_symbol(argv[5]);
-  std::string out_path(argv[6]);
+  std::string data_file(args[0]);
+  std::vector<double> sweep = parse_max_missing(args[1]);
+  std::size_t row_lb = std::stoul(args[2]);
+  std::size_t col_lb = std::stoul(args[3]);
+  std::string na_symbol(args[4]);
+  std::string out_path(args[5]);
 
   std::size_t num_header_rows = 1;
   std::size_t num_header_cols = 1;
-  if (argc == 9) {
-    num_header_rows = std::stoul(argv[7]);
-    num_header_cols = std::stoul(argv[8]);
+  if (args.size() == 8) {
+    num_header_rows = std::stoul(args[6]);
+    num_header_cols = std::stoul(args[7]);
+  }
+
+  if (num_threads < 1) {
+    fprintf(stderr, "ERROR - Number of threads must be at least 1.\n");
+    exit(EXIT_FAILURE);
+  }
+
+  for (auto max_perc_missing : sweep) {
+    if ((max_perc_missing < 0) || (max_perc_missing > 1)) {
+      throw std::runtime_error("max_perc_missing must be between [0,1].");
+    }
   }
 
-  if ((max_perc_missing < 0) || (max_perc_missing > 1)) {
-    throw std::runtime_error("max_perc_missing must be between [0,1].");
+  // Trajectories are recorded by the add-row greedy solver, which only runs
+  // without missing data
+  if ((trajectory || !from_trajectory.empty()) && (sweep.size() != 1 || sweep[0] != 0.0 || continuation)) {
+    fprintf(stderr, "ERROR - --trajectory and --from-trajectory require a single max_missing of 0.\n");
+    exit(EXIT_FAILURE);
+  }
+  if (num_starts > 0 && (sweep.size() != 1 || !from_trajectory.empty())) {
+    fprintf(stderr, "ERROR - --multi-start requires a single max_missing and cannot be used with --from-trajectory.\n");
+    exit(EXIT_FAILURE);
   }
 
   Timer timer;
   timer.start();
 
-  BinContainer data(data_file, na_symbol, num_header_rows, num_header_cols);
+  BinContainer data(data_file, na_symbol, num_header_rows, num_header_cols, num_threads, delim, cache_dir);
+  if (data.is_loaded_from_cache()) {
+    fprintf(stderr, "Loaded mask from cache\n");
+  }
   fprintf(stderr, "Num rows: %lu\n", data.get_num_data_rows());
   fprintf(stderr, "Num cols: %lu\n", data.get_num_data_cols());
   fprintf(stderr, "Num valid data: %lu\n", data.get_num_valid_data());
-  fprintf(stderr, "Max percent missing: %lf\n\n", max_perc_missing);
+  for (auto max_perc_missing : sweep) {
+    fprintf(stderr, "Max percent missing: %lf\n", max_perc_missing);
+  }
+  fprintf(stderr, "\n");
 
   // Check that row_lb and col_lb are <= num_data_rows and num_data_cols
   if (row_lb > data.get_num_data_rows()) {
@@ -61,63 +232,577 @@ int main(int argc, char *argv[]) {
     fprintf(stderr, "ERROR - col_lb must be <= num_data_cols (%lu vs. %lu).\n", col_lb, data.get_num_data_cols());
     exit(EXIT_FAILURE);
   }
-  
-  CleanSolution sol(data.get_num_data_rows(), data.get_num_data_cols());
 
-  GreedySolver greedy_solver(data, max_perc_missing, row_lb, col_lb);
-  fprintf(stderr, "running greedy\n");
-  greedy_solver.solve();
-  sol.update(greedy_solver.get_rows_kept_as_bool(), greedy_solver.get_cols_kept_as_bool());
+  ThreadPool pool(num_threads);
 
-  if (max_perc_missing == 0.0) {
-    AddRowGreedy ar_greedy(data, row_lb, col_lb);
-    fprintf(stderr, "running add-row greedy\n");
-    ar_greedy.solve();
-
-    auto ar_rows_to_keep = ar_greedy.get_rows_to_keep();
-    auto ar_cols_to_keep = ar_greedy.get_cols_to_keep();
+  if (!from_trajectory.empty()) {
+    CleanSolution sol = solve_from_trajectory(data, from_trajectory, row_lb, col_lb);
+    timer.stop();
+    write_solution(data, sol, std::vector<SolverPortfolio::Run>(), data_file, out_path, sweep[0], timer.elapsed_wall_time(), num_threads, compress, solver_summary);
+    return 0;
+  }
 
-    std::size_t ar_num_elements_kept = data.get_num_valid_data_kept(ar_rows_to_keep, ar_cols_to_keep);
-    std::size_t greedy_num_elements_kept = data.get_num_valid_data_kept(sol.get_rows_to_keep(), sol.get_cols_to_keep());
+  if (sweep.size() == 1) {
+    std::string trajectory_file;
+    if (trajectory) {
+      trajectory_file = get_partial_file(data_file, out_path, sweep[0]) + "_trajectory.tsv";
+    }
 
-    if (ar_num_elements_kept > greedy_num_elements_kept) {
-      sol.update(ar_rows_to_keep, ar_cols_to_keep);
+    // A traced greedy solve runs to the end
+    GreedySolver greedy_solver(data, sweep[0], row_lb, col_lb, num_threads > 1 ? &pool : nullptr);
+    if (trace) {
+      greedy_solver.record_trace();
     }
+    fprintf(stderr, "running greedy\n");
+    std::vector<SolverPortfolio::Run> runs;
+    CleanSolution sol = solve_portfolio(data, greedy_solver, !trace, row_lb, col_lb, trajectory_file,
+                                        num_threads > 1, runs);
+    if (trace) {
+      write_trace(greedy_solver, data_file, out_path);
+    }
+    if (num_starts > 0) {
+      run_multi_start(data, sol, sweep[0], row_lb, col_lb, seed, num_starts, time_budget,
+                      num_threads > 1 ? &pool : nullptr, runs);
+    }
+    timer.stop();
+    write_solution(data, sol, runs, data_file, out_path, sweep[0], timer.elapsed_wall_time(), num_threads, compress, solver_summary);
+    return 0;
   }
 
+  // Sweep: the input is parsed once and the thresholds are solved concurrently,
+  // one per thread. Each thread writes its outputs as soon as its solve is
+  // done, while the others are still solving. The reported time of a
+  // threshold is the wall time of the parse plus that of its own solve.
   timer.stop();
+  const double load_time = timer.elapsed_wall_time();
 
-  auto rows_to_keep = sol.get_rows_to_keep();
-  auto cols_to_keep = sol.get_cols_to_keep();
+  if (continuation) {
+    run_continuation(data, sweep, row_lb, col_lb, data_file, out_path, load_time, compare_cold, trace, compress,
+                     solver_summary, num_threads > 1 ? &pool : nullptr);
+    return 0;
+  }
 
-  double time = timer.elapsed_cpu_time();
-  std::size_t num_val_elements = data.get_num_valid_data_kept(rows_to_keep, cols_to_keep);
-  std::size_t num_rows_kept = sol.get_num_rows_kept();
-  std::size_t num_cols_kept = sol.get_num_cols_kept(); 
-  
+  std::atomic<std::size_t> next(0);
+
+  pool.parallel_for(pool.get_num_threads(), 1, [&](std::size_t, std::size_t, std::size_t) {
+    std::size_t g;
+    while ((g = next++) < sweep.size()) {
+      Timer gamma_timer(true);
+      GreedySolver greedy_solver(data, sweep[g], row_lb, col_lb);
+      if (trace) {
+        greedy_solver.record_trace();
+      }
+      fprintf(stderr, "running greedy\n");
+      std::vector<SolverPortfolio::Run> runs;
+      // Every thread already solves a value, so the solvers of one value run
+      // one after the other
+      CleanSolution sol = solve_portfolio(data, greedy_solver, !trace, row_lb, col_lb, "", false, runs);
+      if (trace) {
+        write_trace(greedy_solver, data_file, out_path);
+      }
+      gamma_timer.stop();
+      write_solution(data, sol, runs, data_file, out_path, sweep[g], load_time + gamma_timer.elapsed_wall_time(), 1, compress, solver_summary);
+    }
+  });
+
+  return 0;
+}
+
+//------------------------------------------------------------------------------
+// Parses the <max_missing> argument. It is either a single value, a comma
+// separated list of values or a range written as start:stop:step, which
+// includes stop when it falls on a step. Range values are rounded to 9
+// decimals so that, for example, 0:0.5:0.05 yields the same thresholds as
+// typing 0.15 or 0.35 directly. Output files are named after the values with 2
+// decimals, so values that give the same name, such as 0.101 and 0.102 or a
+// repeated value, are rejected.
+//------------------------------------------------------------------------------
+std::vector<double> parse_max_missing(const std::string &arg) {
+  std::vector<double> values;
+
+  if (arg.find(':') != std::string::npos) {
+    std::stringstream ss(arg);
+    std::string start_s, stop_s, step_s;
+    if (!std::getline(ss, start_s, ':') || !std::getline(ss, stop_s, ':') || !std::getline(ss, step_s)) {
+      fprintf(stderr, "ERROR - max_missing range must be written as start:stop:step.\n");
+      exit(EXIT_FAILURE);
+    }
+
+    const double start = std::stod(start_s);
+    const double stop = std::stod(stop_s);
+    const double step = std::stod(step_s);
+    if (step <= 0 || stop < start) {
+      fprintf(stderr, "ERROR - max_missing range needs step > 0 and stop >= start.\n");
+      exit(EXIT_FAILURE);
+    }
+
+    const std::size_t num_steps = static_cast<std::size_t>(std::floor((stop - start) / step + 1e-9));
+    for (std::size_t i = 0; i <= num_steps; ++i) {
+      values.push_back(std::round((start + i * step) * 1e9) / 1e9);
+    }
+  } else {
+    std::stringstream ss(arg);
+    std::string value;
+    while (std::getline(ss, value, ',')) {
+      values.push_back(std::stod(value));
+    }
+  }
+
+  if (values.empty()) {
+    fprintf(stderr, "ERROR - No max_missing value given.\n");
+    exit(EXIT_FAILURE);
+  }
+
+  std::set<std::string> names;
+  for (auto value : values) {
+    if (!names.insert(format_max_missing(value)).second) {
+      fprintf(stderr, "ERROR - max_missing values must differ with 2 decimals, %s is given more than once.\n",
+              format_max_missing(value).c_str());
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  return values;
+}
+
+//------------------------------------------------------------------------------
+// Solves with the greedy solver and the add-based greedy solvers and returns
+// the solution that keeps the most valid elements, the first of greedy,
+// add-row and add-column on ties. When no missing data is allowed, the add-row
+// and add-column greedy solvers are run, otherwise the add-row one. When
+// 'concurrent', the greedy solver runs on the calling thread, with the thread
+// pool it was given, while the add-based solvers run on one more thread.
+// Otherwise they all run one after the other. Solvers stop as soon as they
+// cannot reach the best solution found so far, except the greedy solver when
+// 'cancel_greedy' is false. Unless
+// 'trajectory_file' is empty, the add-row trajectory is written to it. The
+// outcome of each solver is returned in 'runs'.
+//------------------------------------------------------------------------------
+CleanSolution solve_portfolio(const BinContainer &data,
+                              GreedySolver &greedy_solver,
+                              const bool cancel_greedy,
+                              const std::size_t row_lb,
+                              const std::size_t col_lb,
+                              const std::string &trajectory_file,
+                              const bool concurrent,
+                              std::vector<SolverPortfolio::Run> &runs) {
+  SolverPortfolio portfolio(data);
+
+  portfolio.add_solver("greedy", [&](const std::atomic<std::size_t> *incumbent,
+                                     std::vector<bool> &rows_to_keep,
+                                     std::vector<bool> &cols_to_keep) {
+    if (cancel_greedy) {
+      greedy_solver.set_incumbent(incumbent);
+    }
+    greedy_solver.solve();
+#ifdef MRCLEAN_COUNT_ALLOCATIONS
+    fprintf(stderr, "Greedy solve heap allocations: %lu\n", greedy_solver.get_num_solve_allocations());
+#endif
+    if (greedy_solver.is_abandoned()) {
+      return false;
+    }
+    rows_to_keep = greedy_solver.get_rows_kept_as_bool();
+    cols_to_keep = greedy_solver.get_cols_kept_as_bool();
+    return true;
+  });
+
+  if (greedy_solver.get_max_perc_miss() == 0.0) {
+    for (std::size_t k = 0; k < 2; ++k) {
+      portfolio.add_solver(k == 0 ? "add-row" : "add-col", [&, k](const std::atomic<std::size_t> *incumbent,
+                                                                  std::vector<bool> &rows_to_keep,
+                                                                  std::vector<bool> &cols_to_keep) {
+        std::unique_ptr<AddRowGreedy> add_greedy(k == 0 ? new AddRowGreedy(data, row_lb, col_lb)
+                                                        : new AddColGreedy(data, row_lb, col_lb));
+        const bool recording = k == 0 && !trajectory_file.empty();
+        if (recording) {
+          add_greedy->record_trajectory();
+        }
+        add_greedy->set_incumbent(incumbent);
+        add_greedy->solve();
+        if (recording) {
+          write_trajectory(trajectory_file, *add_greedy);
+        }
+        fprintf(stderr, "%s greedy iterations pruned: %lu\n", k == 0 ? "Add-row" : "Add-col",
+                add_greedy->get_num_pruned_iterations());
+        if (!add_greedy->has_solution()) {
+          return false;
+        }
+        rows_to_keep = add_greedy->get_rows_to_keep();
+        cols_to_keep = add_greedy->get_cols_to_keep();
+        return true;
+      });
+    }
+  } else {
+    portfolio.add_solver("add-row", [&](const std::atomic<std::size_t> *incumbent,
+                                        std::vector<bool> &rows_to_keep,
+                                        std::vector<bool> &cols_to_keep) {
+      AddRowGammaGreedy ar_greedy(data, greedy_solver.get_max_perc_miss(), row_lb, col_lb);
+      ar_greedy.set_incumbent(incumbent);
+      ar_greedy.solve();
+      fprintf(stderr, "Add-row greedy iterations pruned: %lu\n", ar_greedy.get_num_pruned_iterations());
+      if (ar_greedy.get_num_rows_to_keep() == 0) {
+        return false;
+      }
+      rows_to_keep = ar_greedy.get_rows_to_keep();
+      cols_to_keep = ar_greedy.get_cols_to_keep();
+      return true;
+    });
+  }
+
+  portfolio.solve(concurrent);
+
+  runs = portfolio.get_runs();
+  for (const auto &run : runs) {
+    if (run.solved) {
+      fprintf(stderr, "Solver %s: %lf s, %lu valid elements\n", run.name.c_str(), run.time, run.num_valid);
+    } else {
+      fprintf(stderr, "Solver %s: %lf s, given up\n", run.name.c_str(), run.time);
+    }
+  }
+
+  // The greedy solver only gives up early once another solver has a solution,
+  // so without any solution it reached a dimension limit, which its kept rows
+  // and columns tell. The add-based solvers can fail as well, when no rows and
+  // columns within the bounds meet the requirement.
+  if (!portfolio.is_solved()) {
+    if (greedy_solver.get_num_rows_kept() == row_lb && greedy_solver.get_num_cols_kept() == col_lb) {
+      fprintf(stderr, "ERROR - Matrix is at dimension limit (%lu x %lu), but fails percent missing requirement\n", row_lb, col_lb);
+    } else if (greedy_solver.get_num_rows_kept() == row_lb) {
+      fprintf(stderr, "ERROR - Could not find row with missing data over threshold.\n");
+    } else {
+      fprintf(stderr, "ERROR - Could not find column with missing data over threshold.\n");
+    }
+    exit(EXIT_FAILURE);
+  }
+  fprintf(stderr, "Best solver: %s\n", portfolio.get_best_solver().c_str());
+
+  return CleanSolution(portfolio.get_rows_to_keep(), portfolio.get_cols_to_keep());
+}
+
+//------------------------------------------------------------------------------
+// Writes the trajectory of a solved add-row greedy solver: one line per
+// inclusion with the step, the included data row (counted from 0, without
+// header rows), the number of columns left and the number of valid elements.
+//------------------------------------------------------------------------------
+void write_trajectory(const std::string &file_name,
+                      const AddRowGreedy &ar_greedy) {
+  FILE *output;
+
+  if ((output = fopen(file_name.c_str(), "w")) == nullptr) {
+    fprintf(stderr, "Could not open file (%s)", file_name.c_str());
+    exit(EXIT_FAILURE);
+  }
+
+  const std::vector<std::size_t> &rows = ar_greedy.get_row_order();
+  const std::vector<std::size_t> &num_cols = ar_greedy.get_num_cols_by_step();
+  fprintf(output, "step\trow\tnum_cols\tnum_valid\n");
+  for (std::size_t k = 0; k < num_cols.size(); ++k) {
+    fprintf(output, "%lu\t%lu\t%lu\t%lu\n", k + 1, rows[k], num_cols[k], (k + 1) * num_cols[k]);
+  }
+
+  if (fclose(output) != 0) {
+    fprintf(stderr, "ERROR - Could not write trajectory file (%s).\n", file_name.c_str());
+    exit(EXIT_FAILURE);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Runs 'num_starts' greedy starts with randomized ties and replaces 'sol' with
+// the best of them if it keeps more valid elements. Their outcome is added to
+// 'runs'.
+//------------------------------------------------------------------------------
+void run_multi_start(const BinContainer &data,
+                     CleanSolution &sol,
+                     const double max_perc_missing,
+                     const std::size_t row_lb,
+                     const std::size_t col_lb,
+                     const uint64_t seed,
+                     const std::size_t num_starts,
+                     const double time_budget,
+                     ThreadPool *pool,
+                     std::vector<SolverPortfolio::Run> &runs) {
+  MultiStartGreedy multi_start(data, max_perc_missing, row_lb, col_lb, seed, num_starts, time_budget);
+  fprintf(stderr, "running multi-start greedy\n");
+  Timer multi_start_timer(true);
+  multi_start.solve(sol.get_rows_to_keep(), sol.get_cols_to_keep(), pool);
+  multi_start_timer.stop();
+
+  fprintf(stderr, "Multi-start greedy: %lf s, %lu of %lu starts run, %lu greedy solves given up, ",
+          multi_start_timer.elapsed_wall_time(), multi_start.get_num_started(), num_starts,
+          multi_start.get_num_abandoned());
+  if (multi_start.is_improved()) {
+    fprintf(stderr, "start %lu improved to %lu valid elements\n", multi_start.get_best_start(),
+            multi_start.get_num_valid_kept());
+    sol.update(multi_start.get_rows_to_keep(), multi_start.get_cols_to_keep());
+  } else {
+    fprintf(stderr, "no improvement on %lu valid elements\n", multi_start.get_num_valid_kept());
+  }
+
+  SolverPortfolio::Run run = {"multi-start", multi_start_timer.elapsed_wall_time(), true,
+                              multi_start.get_num_valid_kept(), sol.get_num_rows_kept(), sol.get_num_cols_kept()};
+  runs.push_back(run);
+}
+
+//------------------------------------------------------------------------------
+// Writes the removal trace of a solved greedy solver next to its solution,
+// for mrclean-replay. A solve given up at a dimension limit has no solution to
+// trace, so nothing is written.
+//------------------------------------------------------------------------------
+void write_trace(const GreedySolver &greedy_solver,
+                 const std::string &data_file,
+                 const std::string &out_path) {
+  if (greedy_solver.is_abandoned()) {
+    fprintf(stderr, "Greedy solve reached a dimension limit, no trace written\n");
+    return;
+  }
+
+  std::string file_name = get_partial_file(data_file, out_path, greedy_solver.get_max_perc_miss()) + "_trace.bin";
+  if (!greedy_solver.get_trace().save(file_name)) {
+    fprintf(stderr, "ERROR - Could not write trace file (%s).\n", file_name.c_str());
+    exit(EXIT_FAILURE);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Builds the add-row greedy solution for 'row_lb' and 'col_lb' from a
+// trajectory written by write_trajectory(), without solving. The best step is
+// the first with the most valid elements among those with at least 'row_lb'
+// rows and 'col_lb' columns, as in AddRowGreedy::solve(). The kept columns are
+// those valid in every row up to that step.
+//------------------------------------------------------------------------------
+CleanSolution solve_from_trajectory(const BinContainer &data,
+                                    const std::string &trajectory_file,
+                                    const std::size_t row_lb,
+                                    const std::size_t col_lb) {
+  FILE *input;
+
+  if ((input = fopen(trajectory_file.c_str(), "r")) == nullptr) {
+    fprintf(stderr, "Could not open file (%s)", trajectory_file.c_str());
+    exit(EXIT_FAILURE);
+  }
+
+  std::vector<std::size_t> rows;
+  std::vector<std::size_t> num_cols;
+  std::size_t step, row, cols, valid;
+  if (fscanf(input, "%*[^\n]\n") != 0) {
+    fprintf(stderr, "ERROR - Could not read trajectory file (%s).\n", trajectory_file.c_str());
+    exit(EXIT_FAILURE);
+  }
+  while (fscanf(input, "%lu\t%lu\t%lu\t%lu\n", &step, &row, &cols, &valid) == 4) {
+    if (step != rows.size() + 1 || row >= data.get_num_data_rows() || cols > data.get_num_data_cols()) {
+      fprintf(stderr, "ERROR - Trajectory file (%s) does not match the data file.\n", trajectory_file.c_str());
+      exit(EXIT_FAILURE);
+    }
+    rows.push_back(row);
+    num_cols.push_back(cols);
+  }
+  const bool at_end = feof(input);
+  fclose(input);
+  if (!at_end) {
+    fprintf(stderr, "ERROR - Could not read trajectory file (%s).\n", trajectory_file.c_str());
+    exit(EXIT_FAILURE);
+  }
+
+  std::size_t best_obj_value = 0;
+  std::size_t best_num_rows = 0;
+  for (std::size_t k = 0; k < rows.size(); ++k) {
+    if ((k + 1) * num_cols[k] > best_obj_value && k + 1 >= row_lb && num_cols[k] >= col_lb) {
+      best_obj_value = (k + 1) * num_cols[k];
+      best_num_rows = k + 1;
+    }
+  }
+
+  std::vector<bool> rows_to_keep(data.get_num_data_rows(), false);
+  std::vector<uint64_t> valid_cols = mr_clean_utils::make_full_mask(data.get_num_data_cols());
+  for (std::size_t k = 0; k < best_num_rows; ++k) {
+    rows_to_keep[rows[k]] = true;
+    const uint64_t *words = data.get_row_words(rows[k]);
+    for (std::size_t w = 0; w < valid_cols.size(); ++w) {
+      valid_cols[w] &= words[w];
+    }
+  }
+
+  std::vector<bool> cols_to_keep(data.get_num_data_cols(), true);
+  std::size_t num_cols_kept = 0;
+  for (std::size_t j = 0; j < cols_to_keep.size(); ++j) {
+    cols_to_keep[j] = mr_clean_utils::test_bit(valid_cols.data(), j);
+    num_cols_kept += cols_to_keep[j];
+  }
+  if (best_num_rows > 0 && num_cols_kept != num_cols[best_num_rows - 1]) {
+    fprintf(stderr, "ERROR - Trajectory file (%s) does not match the data file.\n", trajectory_file.c_str());
+    exit(EXIT_FAILURE);
+  }
+
+  fprintf(stderr, "Trajectory step %lu of %lu: %lu rows, %lu cols, %lu valid elements\n",
+          best_num_rows, rows.size(), best_num_rows, num_cols_kept, best_obj_value);
+
+  return CleanSolution(rows_to_keep, cols_to_keep);
+}
+
+//------------------------------------------------------------------------------
+// Solves the sweep values from the loosest to the tightest, each greedy solve
+// continuing from the state the previous one finished in. The reported time of
+// a value is the parse time plus the time of the continuation chain up to and
+// including it. With 'compare_cold', every value is also solved from the full
+// matrix, the two greedy solutions and run times are reported and the cold
+// solution is written instead when it keeps more valid elements.
+//------------------------------------------------------------------------------
+void run_continuation(const BinContainer &data,
+                      const std::vector<double> &sweep,
+                      const std::size_t row_lb,
+                      const std::size_t col_lb,
+                      const std::string &data_file,
+                      const std::string &out_path,
+                      const double load_time,
+                      const bool compare_cold,
+                      const bool trace,
+                      const bool compress,
+                      const bool solver_summary,
+                      ThreadPool *pool) {
+  std::vector<double> order(sweep);
+  std::sort(order.begin(), order.end(), std::greater<double>());
+
+  std::unique_ptr<GreedySolver> warm;
+  double chain_time = 0;
+  double total_warm_time = 0;
+  double total_cold_time = 0;
+  std::size_t num_matching = 0;
+
+  for (auto max_perc_missing : order) {
+    Timer gamma_timer(true);
+    Timer warm_timer(true);
+    if (warm) {
+      warm.reset(new GreedySolver(*warm, max_perc_missing));
+    } else {
+      warm.reset(new GreedySolver(data, max_perc_missing, row_lb, col_lb, pool));
+      if (trace) {
+        warm->record_trace();
+      }
+    }
+    warm_timer.stop();
+
+    // The next value continues from the warm solver, so it is never given up
+    // early. It still gives up at a dimension limit, and so do the tighter
+    // values after it.
+    fprintf(stderr, "running greedy (continuation)\n");
+    std::vector<SolverPortfolio::Run> runs;
+    CleanSolution sol = solve_portfolio(data, *warm, false, row_lb, col_lb, "", pool != nullptr, runs);
+    if (trace) {
+      write_trace(*warm, data_file, out_path);
+    }
+    gamma_timer.stop();
+    chain_time += gamma_timer.elapsed_wall_time();
+
+    if (compare_cold) {
+      Timer cold_timer(true);
+      GreedySolver cold(data, max_perc_missing, row_lb, col_lb, pool);
+      cold.solve();
+      cold_timer.stop();
+
+      // A solve given up at a dimension limit has no solution, counted as 0
+      // valid elements
+      const bool warm_solved = !warm->is_abandoned();
+      const bool cold_solved = !cold.is_abandoned();
+      const bool match = warm_solved == cold_solved &&
+                         (!warm_solved ||
+                          (cold.get_rows_kept_as_bool() == warm->get_rows_kept_as_bool() &&
+                           cold.get_cols_kept_as_bool() == warm->get_cols_kept_as_bool()));
+      const std::size_t warm_valid = warm_solved ? data.get_num_valid_data_kept(warm->get_rows_kept_as_bool(), warm->get_cols_kept_as_bool()) : 0;
+      const std::size_t cold_valid = cold_solved ? data.get_num_valid_data_kept(cold.get_rows_kept_as_bool(), cold.get_cols_kept_as_bool()) : 0;
+      const double warm_time = warm_timer.elapsed_wall_time() + runs[0].time;
+      const double cold_time = cold_timer.elapsed_wall_time();
+      fprintf(stderr, "Continuation %lf: warm %lf s, cold %lf s, speedup %.2fx, %s (valid elements warm %lu, cold %lu)\n",
+              max_perc_missing, warm_time, cold_time, warm_time > 0 ? cold_time / warm_time : 0.0,
+              match ? "solutions match" : "solutions differ", warm_valid, cold_valid);
+
+      total_warm_time += warm_time;
+      total_cold_time += cold_time;
+      num_matching += match;
+
+      // Keep the cold solution when it is better
+      if (cold_valid > data.get_num_valid_data_kept(sol.get_rows_to_keep(), sol.get_cols_to_keep())) {
+        sol.update(cold.get_rows_kept_as_bool(), cold.get_cols_kept_as_bool());
+      }
+    }
+
+    write_solution(data, sol, runs, data_file, out_path, max_perc_missing, load_time + chain_time,
+                   pool != nullptr ? pool->get_num_threads() : 1, compress, solver_summary);
+  }
+
+  if (compare_cold) {
+    fprintf(stderr, "Continuation: %lu of %lu solutions match cold starts, greedy time warm %lf s, cold %lf s, speedup %.2fx\n",
+            num_matching, order.size(), total_warm_time, total_cold_time,
+            total_warm_time > 0 ? total_cold_time / total_warm_time : 0.0);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Returns the output path and name, without suffix, of the files written for
+// one max_perc_missing.
+//------------------------------------------------------------------------------
+std::string get_partial_file(const std::string &data_file,
+                             const std::string &out_path,
+                             const double max_perc_missing) {
   std::size_t file_start = data_file.find_last_of("/");
   std::string file_name = data_file.substr(file_start+1);
 
+  // A compressed data file keeps the name it had before compression
+  if (file_name.size() > 3 && file_name.compare(file_name.size() - 3, 3, ".gz") == 0) {
+    file_name = file_name.substr(0, file_name.size() - 3);
+  }
   std::size_t last_index = file_name.find_last_of(".");
   file_name = file_name.substr(0, last_index);
+  return out_path + file_name + "_gamma_" + format_max_missing(max_perc_missing);
+}
+
+//------------------------------------------------------------------------------
+// Returns 'max_perc_missing' with 2 decimals, as used in output file names.
+//------------------------------------------------------------------------------
+std::string format_max_missing(const double max_perc_missing) {
   std::stringstream gamma;
   gamma << std::fixed << std::setprecision(2) << max_perc_missing;
-  std::string partial_file = out_path + file_name + "_gamma_" + gamma.str().c_str();
+  return gamma.str();
+}
+
+//------------------------------------------------------------------------------
+// Writes the cleaned data file, the retained rows and columns file and the
+// summary line for one max_perc_missing. With 'solver_summary', the outcome of
+// each solver in 'runs' is also written to the solver summary file.
+//------------------------------------------------------------------------------
+void write_solution(const BinContainer &data,
+                    CleanSolution &sol,
+                    const std::vector<SolverPortfolio::Run> &runs,
+                    const std::string &data_file,
+                    const std::string &out_path,
+                    const double max_perc_missing,
+                    const double time,
+                    const std::size_t num_write_threads,
+                    const bool compress,
+                    const bool solver_summary) {
+  auto rows_to_keep = sol.get_rows_to_keep();
+  auto cols_to_keep = sol.get_cols_to_keep();
+
+  std::size_t num_val_elements = data.get_num_valid_data_kept(rows_to_keep, cols_to_keep);
+  std::size_t num_rows_kept = sol.get_num_rows_kept();
+  std::size_t num_cols_kept = sol.get_num_cols_kept();
+
+  std::string partial_file = get_partial_file(data_file, out_path, max_perc_missing);
 
-  std::string cleaned_file =  partial_file + "_cleaned.tsv";
-  data.write_orig(cleaned_file, rows_to_keep, cols_to_keep);
+  std::string cleaned_file =  partial_file + (compress ? "_cleaned.tsv.gz" : "_cleaned.tsv");
+  data.write_orig(cleaned_file, rows_to_keep, cols_to_keep, num_write_threads);
 
   write_stats_to_file("Greedy_summary.csv", data_file, max_perc_missing, time, num_val_elements, num_rows_kept, num_cols_kept);
+  if (solver_summary) {
+    write_solver_stats_to_file("Greedy_solver_summary.csv", data_file, max_perc_missing, runs);
+  }
 
   // Write rows and cols kept
   std::string sol_file = partial_file + "_cleaned.sol";
   sol.write_to_file(sol_file);
-
-  return 0;
 }
 
 //------------------------------------------------------------------------------
-// Write the statistics to a file
+// Write the statistics to a file. Concurrent sweep threads are serialized.
 //------------------------------------------------------------------------------
 void write_stats_to_file(const std::string &file_name,
                          const std::string &data_file,
@@ -126,8 +811,11 @@ void write_stats_to_file(const std::string &file_name,
                          const std::size_t num_valid_element,
                          const std::size_t num_rows_kept,
                          const std::size_t num_cols_kept) {
+  static std::mutex summary_mutex;
+  std::lock_guard<std::mutex> lock(summary_mutex);
+
   FILE *summary;
-  
+
   if((summary = fopen(file_name.c_str(), "a+")) == nullptr) {
     fprintf(stderr, "Could not open file (%s)", file_name.c_str());
     exit(EXIT_FAILURE);
@@ -137,3 +825,29 @@ void write_stats_to_file(const std::string &file_name,
 
   fclose(summary);
 }
+
+//------------------------------------------------------------------------------
+// Write a line for each solver in 'runs' to a file, with its own wall time and
+// zero counts if it gave up. The lines of one call are written together.
+//------------------------------------------------------------------------------
+void write_solver_stats_to_file(const std::string &file_name,
+                                const std::string &data_file,
+                                const double max_perc_missing,
+                                const std::vector<SolverPortfolio::Run> &runs) {
+  static std::mutex summary_mutex;
+  std::lock_guard<std::mutex> lock(summary_mutex);
+
+  FILE *summary;
+
+  if((summary = fopen(file_name.c_str(), "a+")) == nullptr) {
+    fprintf(stderr, "Could not open file (%s)", file_name.c_str());
+    exit(EXIT_FAILURE);
+  }
+
+  for (const auto &run : runs) {
+    fprintf(summary, "%s,%lf,%s,%lf,%lu,%lu,%lu\n", data_file.c_str(), max_perc_missing, run.name.c_str(),
+            run.time, run.num_valid, run.num_rows_kept, run.num_cols_kept);
+  }
+
+  fclose(summary);
+}
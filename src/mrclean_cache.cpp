@@ -0,0 +1,169 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <stdexcept>
+#include <string>
+#include <sys/stat.h>
+#include <vector>
+
+#include "BinContainer.h"
+#include "BitMatrix.h"
+#include "MaskCache.h"
+
+struct CacheOptions {
+  std::string cache_dir;
+  std::string na_symbol;
+  std::size_t num_header_rows;
+  std::size_t num_header_cols;
+  std::size_t num_threads;
+  char delim;
+};
+
+std::vector<std::string> list_data_files(const std::string &path);
+bool build_cache(const std::string &data_file, const CacheOptions &options);
+bool verify_cache(const std::string &data_file, const CacheOptions &options);
+
+int main(int argc, char *argv[]) {
+  CacheOptions options;
+  options.num_header_rows = 1;
+  options.num_header_cols = 1;
+  options.num_threads = 1;
+  options.delim = '\t';
+
+  // Separate options from positional arguments
+  std::vector<std::string> args;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg(argv[i]);
+    if (arg == "--hr" && i + 1 < argc) {
+      options.num_header_rows = std::stoul(argv[++i]);
+    } else if (arg == "--hc" && i + 1 < argc) {
+      options.num_header_cols = std::stoul(argv[++i]);
+    } else if (arg == "--threads" && i + 1 < argc) {
+      options.num_threads = std::stoul(argv[++i]);
+    } else if (arg == "--delim" && i + 1 < argc) {
+      std::string name(argv[++i]);
+      if (name == "tab") {
+        options.delim = '\t';
+      } else if (name == "comma") {
+        options.delim = ',';
+      } else if (name == "space") {
+        options.delim = ' ';
+      } else {
+        fprintf(stderr, "ERROR - Unknown delimiter '%s' (expected tab, comma or space).\n", name.c_str());
+        exit(EXIT_FAILURE);
+      }
+    } else {
+      args.push_back(arg);
+    }
+  }
+
+  if (args.size() < 4 || (args[0] != "build" && args[0] != "verify")) {
+    fprintf(stderr, "Usage: %s build|verify [--hr <n>] [--hc <n>] [--delim tab|comma|space] [--threads <n>] <cache_dir> <na_symbol> <data_file|data_dir>...\n", argv[0]);
+    exit(EXIT_FAILURE);
+  }
+
+  const bool build = args[0] == "build";
+  options.cache_dir = args[1];
+  options.na_symbol = args[2];
+
+  std::size_t num_failed = 0;
+  for (std::size_t k = 3; k < args.size(); ++k) {
+    for (const auto &data_file : list_data_files(args[k])) {
+      const bool ok = build ? build_cache(data_file, options) : verify_cache(data_file, options);
+      num_failed += !ok;
+    }
+  }
+
+  return num_failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+//------------------------------------------------------------------------------
+// Returns 'path' if it is a file, or the regular, non-hidden files directly in
+// it, sorted by name, if it is a directory.
+//------------------------------------------------------------------------------
+std::vector<std::string> list_data_files(const std::string &path) {
+  std::vector<std::string> files;
+
+  struct stat sb;
+  if (stat(path.c_str(), &sb) != 0 || !S_ISDIR(sb.st_mode)) {
+    files.push_back(path);
+    return files;
+  }
+
+  DIR *dir = opendir(path.c_str());
+  if (dir == nullptr) {
+    fprintf(stderr, "ERROR - Could not open directory (%s).\n", path.c_str());
+    return files;
+  }
+
+  struct dirent *entry;
+  while ((entry = readdir(dir)) != nullptr) {
+    if (entry->d_name[0] == '.') {
+      continue;
+    }
+    const std::string file = (path.back() == '/' ? path : path + "/") + entry->d_name;
+    if (stat(file.c_str(), &sb) == 0 && S_ISREG(sb.st_mode)) {
+      files.push_back(file);
+    }
+  }
+  closedir(dir);
+
+  std::sort(files.begin(), files.end());
+  return files;
+}
+
+//------------------------------------------------------------------------------
+// Creates the cache file of 'data_file', or reuses it if it is up to date.
+//------------------------------------------------------------------------------
+bool build_cache(const std::string &data_file, const CacheOptions &options) {
+  try {
+    BinContainer data(data_file, options.na_symbol, options.num_header_rows, options.num_header_cols,
+                      options.num_threads, options.delim, options.cache_dir);
+    printf("%s\t%s\t%lu x %lu\n", data.is_loaded_from_cache() ? "reused" : "cached",
+           data_file.c_str(), data.get_num_data_rows(), data.get_num_data_cols());
+  } catch (const std::exception &e) {
+    printf("error\t%s\t%s\n", data_file.c_str(), e.what());
+    return false;
+  }
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Checks that 'data_file' has an up to date cache file whose mask and line
+// offsets are identical to those of a fresh parse.
+//------------------------------------------------------------------------------
+bool verify_cache(const std::string &data_file, const CacheOptions &options) {
+  MaskCache cache(options.cache_dir, data_file, options.na_symbol, options.num_header_rows,
+                  options.num_header_cols, options.delim);
+  BitMatrix cached;
+  std::vector<uint64_t> cached_offsets;
+  if (!cache.load(cached, cached_offsets)) {
+    printf("missing\t%s\n", data_file.c_str());
+    return false;
+  }
+
+  try {
+    BinContainer data(data_file, options.na_symbol, options.num_header_rows, options.num_header_cols,
+                      options.num_threads, options.delim);
+
+    bool match = cached.get_num_rows() == data.get_num_data_rows() &&
+                 cached.get_num_cols() == data.get_num_data_cols() &&
+                 cached_offsets == data.get_line_offsets();
+    const std::size_t row_bytes = data.get_num_row_words() * sizeof(uint64_t);
+    const std::size_t col_bytes = data.get_num_col_words() * sizeof(uint64_t);
+    for (std::size_t i = 0; match && i < data.get_num_data_rows(); ++i) {
+      match = memcmp(cached.get_row_words(i), data.get_row_words(i), row_bytes) == 0;
+    }
+    for (std::size_t j = 0; match && j < data.get_num_data_cols(); ++j) {
+      match = memcmp(cached.get_col_words(j), data.get_col_words(j), col_bytes) == 0;
+    }
+
+    printf("%s\t%s\n", match ? "ok" : "mismatch", data_file.c_str());
+    return match;
+  } catch (const std::exception &e) {
+    printf("error\t%s\t%s\n", data_file.c_str(), e.what());
+    return false;
+  }
+}
@@ -0,0 +1,99 @@
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "CleanSolution.h"
+#include "RemovalTrace.h"
+
+void print_step(const RemovalTrace &trace, const std::size_t k);
+std::size_t find_step(const RemovalTrace &trace, const std::string &selector, const std::size_t n);
+
+int main(int argc, char *argv[]) {
+  std::vector<std::string> args(argv + 1, argv + argc);
+
+  const bool valid_args = (args.size() == 2 && (args[1] == "steps" || args[1] == "frontier")) ||
+                          (args.size() == 5 && args[1] == "state");
+  if (!valid_args) {
+    fprintf(stderr, "Usage: %s <trace_file> steps|frontier\n", argv[0]);
+    fprintf(stderr, "       %s <trace_file> state step|min-rows|min-cols <n> <sol_file>\n", argv[0]);
+    exit(EXIT_FAILURE);
+  }
+
+  RemovalTrace trace;
+  if (!trace.load(args[0])) {
+    fprintf(stderr, "ERROR - Could not read trace file (%s).\n", args[0].c_str());
+    exit(EXIT_FAILURE);
+  }
+
+  if (args[1] == "steps" || args[1] == "frontier") {
+    printf("step\tnum_rows_kept\tnum_cols_kept\tnum_valid\tperc_missing\n");
+    if (args[1] == "steps") {
+      for (std::size_t k = 0; k <= trace.get_num_steps(); ++k) {
+        print_step(trace, k);
+      }
+    } else {
+      for (auto k : trace.get_frontier()) {
+        print_step(trace, k);
+      }
+    }
+    return EXIT_SUCCESS;
+  }
+
+  const std::size_t k = find_step(trace, args[2], std::stoul(args[3]));
+  std::vector<bool> keep_row;
+  std::vector<bool> keep_col;
+  trace.replay(k, keep_row, keep_col);
+
+  CleanSolution sol(keep_row, keep_col);
+  sol.write_to_file(args[4]);
+  print_step(trace, k);
+
+  return EXIT_SUCCESS;
+}
+
+//------------------------------------------------------------------------------
+// Prints step 'k' of the trace as a line of the steps table.
+//------------------------------------------------------------------------------
+void print_step(const RemovalTrace &trace, const std::size_t k) {
+  const RemovalTrace::Step &step = trace.get_step(k);
+  const uint64_t size = step.num_rows_kept * step.num_cols_kept;
+  printf("%lu\t%lu\t%lu\t%lu\t%lf\n", k, step.num_rows_kept, step.num_cols_kept, step.num_valid,
+         size > 0 ? static_cast<double>(size - step.num_valid) / size : 0.0);
+}
+
+//------------------------------------------------------------------------------
+// Returns the step selected by 'selector': step 'n' itself, or the last step
+// that keeps at least 'n' rows (min-rows) or columns (min-cols), i.e. where
+// the solver would have stopped with that limit.
+//------------------------------------------------------------------------------
+std::size_t find_step(const RemovalTrace &trace, const std::string &selector, const std::size_t n) {
+  if (selector == "step") {
+    if (n > trace.get_num_steps()) {
+      fprintf(stderr, "ERROR - The trace has %lu steps (requested %lu).\n", trace.get_num_steps(), n);
+      exit(EXIT_FAILURE);
+    }
+    return n;
+  }
+
+  if (selector != "min-rows" && selector != "min-cols") {
+    fprintf(stderr, "ERROR - Unknown step selector '%s' (expected step, min-rows or min-cols).\n", selector.c_str());
+    exit(EXIT_FAILURE);
+  }
+
+  const bool by_rows = selector == "min-rows";
+  std::size_t last = trace.get_num_steps() + 1;
+  for (std::size_t k = 0; k <= trace.get_num_steps(); ++k) {
+    const RemovalTrace::Step &step = trace.get_step(k);
+    if ((by_rows ? step.num_rows_kept : step.num_cols_kept) < n) {
+      break;
+    }
+    last = k;
+  }
+
+  if (last > trace.get_num_steps()) {
+    fprintf(stderr, "ERROR - No step keeps at least %lu %s.\n", n, by_rows ? "rows" : "columns");
+    exit(EXIT_FAILURE);
+  }
+  return last;
+}